@@ -811,6 +811,350 @@ void rr_game_init(struct rr_game *this)
         RR_SLOT_COUNT_FROM_LEVEL(level_from_xp(this->cache.experience));
 }
 
+static void read_clientbound_message(struct rr_game *this,
+                                    struct proto_bug *encoder)
+{
+    uint8_t h = proto_bug_read_uint8(encoder, "header");
+    switch (h)
+    {
+    case rr_clientbound_update:
+    {
+        this->socket_error = 0;
+        this->joined_squad = 1;
+
+        this->kick_vote_pos = proto_bug_read_uint8(encoder, "kick vote");
+        for (uint32_t i = 0; i < RR_SQUAD_MEMBER_COUNT; ++i)
+        {
+            this->squad.squad_members[i].in_use =
+                proto_bug_read_uint8(encoder, "bitbit");
+            if (this->squad.squad_members[i].in_use == 0)
+                continue;
+            this->squad.squad_members[i].playing =
+                proto_bug_read_uint8(encoder, "ready");
+            this->squad.squad_members[i].disconnected =
+                proto_bug_read_uint8(encoder, "disconnected");
+            this->squad.squad_members[i].blocked =
+                proto_bug_read_uint8(encoder, "blocked");
+            this->squad.squad_members[i].is_dev =
+                proto_bug_read_uint8(encoder, "is_dev");
+            uint8_t kick_vote_count =
+                proto_bug_read_uint8(encoder, "kick votes");
+            if (this->squad.squad_members[i].kick_vote_count !=
+                kick_vote_count)
+            {
+                this->squad.squad_members[i].kick_vote_count =
+                    kick_vote_count;
+                sprintf(this->squad.squad_members[i].kick_text, "%u/%u",
+                        kick_vote_count, RR_SQUAD_MEMBER_COUNT - 1);
+                if (this->kick_vote_pos == i)
+                    rr_ui_set_background(
+                        this->squad.squad_members[i].kick_text_el,
+                        0xffff4444);
+                else
+                    rr_ui_set_background(
+                        this->squad.squad_members[i].kick_text_el,
+                        0xffffffff);
+            }
+            uint32_t level = proto_bug_read_varuint(encoder, "level");
+            if (this->squad.squad_members[i].level != level)
+            {
+                float health = 200 * pow(1.0256, level - 1);
+                float damage = 0.1 * health;
+                this->squad.squad_members[i].level = level;
+                sprintf(this->squad.squad_members[i].level_text,
+                        "%u", level);
+                rr_sprintf(this->squad.squad_members[i].health_text,
+                           health);
+                rr_sprintf(this->squad.squad_members[i].damage_text,
+                           damage);
+            }
+            proto_bug_read_string(encoder,
+                                  this->squad.squad_members[i].nickname, 16,
+                                  "nickname");
+            for (uint32_t j = 0; j < RR_MAX_SLOT_COUNT * 2; ++j)
+            {
+                this->squad.squad_members[i].loadout[j].id =
+                    proto_bug_read_uint8(encoder, "id");
+                this->squad.squad_members[i].loadout[j].rarity =
+                    proto_bug_read_uint8(encoder, "rar");
+            }
+        }
+        this->squad.squad_index = proto_bug_read_uint8(encoder, "sqidx");
+        this->squad.squad_owner = proto_bug_read_uint8(encoder, "sqown");
+        this->squad.squad_pos = proto_bug_read_uint8(encoder, "sqpos");
+        this->squad.squad_private =
+            proto_bug_read_uint8(encoder, "private");
+        this->squad.squad_expose_code =
+            proto_bug_read_uint8(encoder, "expose_code");
+        this->selected_biome = proto_bug_read_uint8(encoder, "biome");
+        proto_bug_read_string(encoder, this->squad.squad_code, 16,
+                              "squad code");
+        // this->is_dev =
+        //     this->squad.squad_members[this->squad.squad_pos].is_dev;
+        this->afk = proto_bug_read_uint8(encoder, "afk");
+        if (proto_bug_read_uint8(encoder, "in game") == 1)
+        {
+            if (!this->simulation_ready)
+            {
+                rr_simulation_init(this->simulation);
+                rr_simulation_init(this->deletion_simulation);
+                rr_particle_manager_clear(&this->default_particle_manager);
+                rr_particle_manager_clear(
+                    &this->foreground_particle_manager);
+                rr_write_dev_cheat_packets(this, 1);
+                this->simulation_ready = 1;
+            }
+            rr_simulation_read_binary(this, encoder);
+        }
+        else
+        {
+            if (this->simulation_ready)
+            {
+                rr_simulation_init(this->simulation);
+                rr_particle_manager_clear(&this->default_particle_manager);
+                rr_particle_manager_clear(
+                    &this->foreground_particle_manager);
+            }
+            this->simulation_ready = 0;
+            proto_bug_init(encoder, RR_OUTGOING_PACKET);
+            proto_bug_write_uint8(encoder, this->socket.quick_verification, "qv");
+            proto_bug_write_uint8(encoder, rr_serverbound_squad_update,
+                                  "header");
+            proto_bug_write_string(encoder, this->cache.nickname, 16,
+                                   "nickname");
+            proto_bug_write_uint8(encoder, this->slots_unlocked,
+                                  "loadout count");
+            for (uint32_t i = 0; i < this->slots_unlocked; ++i)
+            {
+                proto_bug_write_uint8(encoder, this->cache.loadout[i].id,
+                                      "id");
+                proto_bug_write_uint8(
+                    encoder, this->cache.loadout[i].rarity, "rarity");
+                proto_bug_write_uint8(
+                    encoder,
+                    this->cache.loadout[i + RR_MAX_SLOT_COUNT].id, "id");
+                proto_bug_write_uint8(
+                    encoder,
+                    this->cache.loadout[i + RR_MAX_SLOT_COUNT].rarity,
+                    "rarity");
+            }
+            rr_websocket_send(&this->socket,
+                              encoder->current - encoder->start);
+        }
+        break;
+    }
+    case rr_clientbound_squad_dump:
+    {
+        this->is_dev = proto_bug_read_uint8(encoder, "is_dev");
+        this->kick_vote_pos = proto_bug_read_uint8(encoder, "kick vote");
+        for (uint32_t s = 0; s < RR_SQUAD_COUNT; ++s)
+        {
+            struct rr_game_squad *squad = &this->other_squads[s];
+            for (uint32_t i = 0; i < RR_SQUAD_MEMBER_COUNT; ++i)
+            {
+                squad->squad_members[i].in_use =
+                    proto_bug_read_uint8(encoder, "bitbit");
+                if (squad->squad_members[i].in_use == 0)
+                    continue;
+                squad->squad_members[i].playing =
+                    proto_bug_read_uint8(encoder, "ready");
+                squad->squad_members[i].disconnected =
+                    proto_bug_read_uint8(encoder, "disconnected");
+                squad->squad_members[i].blocked =
+                    proto_bug_read_uint8(encoder, "blocked");
+                squad->squad_members[i].is_dev =
+                    proto_bug_read_uint8(encoder, "is_dev");
+                uint8_t kick_vote_count =
+                    proto_bug_read_uint8(encoder, "kick votes");
+                if (squad->squad_members[i].kick_vote_count !=
+                    kick_vote_count)
+                {
+                    squad->squad_members[i].kick_vote_count =
+                        kick_vote_count;
+                    sprintf(squad->squad_members[i].kick_text, "%u/%u",
+                            kick_vote_count, RR_SQUAD_MEMBER_COUNT - 1);
+                    if (this->joined_squad &&
+                        this->squad.squad_index == s &&
+                        this->kick_vote_pos == i)
+                        rr_ui_set_background(
+                            squad->squad_members[i].kick_text_el,
+                            0xffff4444);
+                    else
+                        rr_ui_set_background(
+                            squad->squad_members[i].kick_text_el,
+                            0xffffffff);
+                }
+                uint32_t level = proto_bug_read_varuint(encoder, "level");
+                if (squad->squad_members[i].level != level)
+                {
+                    float health = 200 * pow(1.0256, level - 1);
+                    float damage = 0.1 * health;
+                    squad->squad_members[i].level = level;
+                    sprintf(squad->squad_members[i].level_text,
+                            "%u", level);
+                    rr_sprintf(squad->squad_members[i].health_text, health);
+                    rr_sprintf(squad->squad_members[i].damage_text, damage);
+                }
+                proto_bug_read_string(encoder,
+                                      squad->squad_members[i].nickname, 16,
+                                      "nickname");
+                for (uint32_t j = 0; j < RR_MAX_SLOT_COUNT * 2; ++j)
+                {
+                    squad->squad_members[i].loadout[j].id =
+                        proto_bug_read_uint8(encoder, "id");
+                    squad->squad_members[i].loadout[j].rarity =
+                        proto_bug_read_uint8(encoder, "rar");
+                }
+            }
+            squad->squad_index = s;
+            squad->squad_owner = proto_bug_read_uint8(encoder, "sqown");
+            squad->squad_private =
+                proto_bug_read_uint8(encoder, "private");
+            squad->squad_expose_code =
+                proto_bug_read_uint8(encoder, "expose_code");
+            this->selected_biome = proto_bug_read_uint8(encoder, "biome");
+            proto_bug_read_string(encoder, squad->squad_code, 16,
+                                  "squad code");
+        }
+        break;
+    }
+    case rr_clientbound_animation_update:
+    {
+        while (proto_bug_read_uint8(encoder, "continue"))
+        {
+            struct rr_simulation_animation *particle;
+            uint8_t type = proto_bug_read_uint8(encoder, "ani type");
+            if (type != rr_animation_type_chat)
+                particle =
+                    rr_particle_alloc(&this->foreground_particle_manager,
+                                      type);
+            switch (type)
+            {
+            case rr_animation_type_lightningbolt:
+                particle->length =
+                    proto_bug_read_uint8(encoder, "ani length");
+                for (uint32_t i = 0; i < particle->length; ++i)
+                {
+                    particle->points[i].x =
+                        proto_bug_read_float32(encoder, "ani x");
+                    particle->points[i].y =
+                        proto_bug_read_float32(encoder, "ani y");
+                }
+                particle->opacity = 0.8;
+                particle->disappearance = 6;
+                break;
+            case rr_animation_type_damagenumber:
+            {
+                particle->x = proto_bug_read_float32(encoder, "ani x");
+                particle->y = proto_bug_read_float32(encoder, "ani y");
+                particle->velocity.x = (rr_frand() - 0.5) * 25;
+                particle->velocity.y = -15 + rr_frand() * 5;
+                particle->acceleration.y = 0.75;
+                particle->friction = 0.9;
+                particle->damage =
+                    proto_bug_read_varuint(encoder, "damage");
+                switch (proto_bug_read_uint8(encoder, "color type"))
+                {
+                case rr_animation_color_type_damage:
+                    particle->color = 0xffff4444;
+                    break;
+                case rr_animation_color_type_heal:
+                    particle->color = 0xffffff44;
+                    break;
+                case rr_animation_color_type_uranium:
+                    particle->color = 0xff63bf2e;
+                    break;
+                case rr_animation_color_type_fireball:
+                    particle->color = 0xffce5d0b;
+                    break;
+                case rr_animation_color_type_lightning:
+                    particle->color = 0xffccccfc;
+                    break;
+                }
+                particle->opacity = 1;
+                particle->disappearance = 6;
+                break;
+            }
+            case rr_animation_type_chat:
+                if (this->chat.at < 9)
+                    this->chat.at++;
+                else
+                {
+                    for (uint8_t i = 0; i < 9; i++)
+                        this->chat.messages[i] = this->chat.messages[i + 1];
+                }
+                struct rr_game_chat_message *message = &this->chat.messages[this->chat.at];
+                proto_bug_read_string(encoder, message->sender_name, 64, "name");
+                proto_bug_read_string(encoder, message->message, 64, "chat");
+                sprintf(message->text, "%s: %s", message->sender_name, message->message);
+                break;
+            case rr_animation_type_area_damage:
+                particle->x = proto_bug_read_float32(encoder, "ani x");
+                particle->y = proto_bug_read_float32(encoder, "ani y");
+                particle->size = proto_bug_read_float32(encoder, "size");
+                switch (proto_bug_read_uint8(encoder, "color type"))
+                {
+                case rr_animation_color_type_uranium:
+                    particle->color = 0x2063bf2e;
+                    break;
+                case rr_animation_color_type_fireball:
+                    particle->color = 0x80ce5d0b;
+                    break;
+                }
+                particle->opacity = 1;
+                particle->disappearance = 10 * sqrtf(500 / particle->size);
+                break;
+            default:
+                break;
+            }
+        }
+        break;
+    }
+    case rr_clientbound_squad_fail:
+        this->socket_error =
+            3 + proto_bug_read_uint8(encoder, "fail type");
+        if (this->simulation_ready)
+        {
+            rr_simulation_init(this->simulation);
+            rr_particle_manager_clear(&this->default_particle_manager);
+            rr_particle_manager_clear(&this->foreground_particle_manager);
+        }
+        this->simulation_ready = 0;
+        this->joined_squad = 0;
+        break;
+    case rr_clientbound_squad_leave:
+        this->joined_squad = 0;
+        break;
+    case rr_clientbound_account_result:
+        rr_game_read_account(this, encoder);
+        break;
+    case rr_clientbound_craft_result:
+    {
+        this->crafting_data.crafting_id =
+            proto_bug_read_uint8(encoder, "craft id");
+        this->crafting_data.crafting_rarity =
+            proto_bug_read_uint8(encoder, "craft rarity");
+        this->crafting_data.temp_successes =
+            proto_bug_read_varuint(encoder, "success count");
+        this->crafting_data.temp_fails =
+            proto_bug_read_varuint(encoder, "fail count");
+        this->crafting_data.temp_attempts =
+            proto_bug_read_varuint(encoder, "attempts");
+        this->crafting_data.temp_xp =
+            proto_bug_read_float64(encoder, "craft xp");
+        this->crafting_data.animation =
+            powf(1.25, this->crafting_data.crafting_rarity);
+        if (this->crafting_data.temp_successes == 0)
+            this->crafting_data.animation *=
+                (5 - (this->crafting_data.count -
+                      this->crafting_data.temp_fails)) / 5.0f;
+        break;
+    }
+    default:
+        RR_UNREACHABLE("how'd this happen");
+    }
+}
+
 void rr_game_websocket_on_event_function(enum rr_websocket_event_type type,
                                          void *data, void *captures,
                                          uint64_t size)
@@ -881,344 +1225,22 @@ void rr_game_websocket_on_event_function(enum rr_websocket_event_type type,
         this->socket.clientbound_encryption_key =
             rr_get_hash(this->socket.clientbound_encryption_key);
         rr_decrypt(data, size, this->socket.clientbound_encryption_key);
-        uint8_t h = proto_bug_read_uint8(&encoder, "header");
-        switch (h)
+        proto_bug_init_deferred(&encoder, data);
+        proto_bug_unmask(&encoder, size);
+        if (proto_bug_read_uint8(&encoder, "header") != rr_clientbound_bundle)
         {
-        case rr_clientbound_update:
-        {
-            this->socket_error = 0;
-            this->joined_squad = 1;
-
-            this->kick_vote_pos = proto_bug_read_uint8(&encoder, "kick vote");
-            for (uint32_t i = 0; i < RR_SQUAD_MEMBER_COUNT; ++i)
-            {
-                this->squad.squad_members[i].in_use =
-                    proto_bug_read_uint8(&encoder, "bitbit");
-                if (this->squad.squad_members[i].in_use == 0)
-                    continue;
-                this->squad.squad_members[i].playing =
-                    proto_bug_read_uint8(&encoder, "ready");
-                this->squad.squad_members[i].disconnected =
-                    proto_bug_read_uint8(&encoder, "disconnected");
-                this->squad.squad_members[i].blocked =
-                    proto_bug_read_uint8(&encoder, "blocked");
-                this->squad.squad_members[i].is_dev =
-                    proto_bug_read_uint8(&encoder, "is_dev");
-                uint8_t kick_vote_count =
-                    proto_bug_read_uint8(&encoder, "kick votes");
-                if (this->squad.squad_members[i].kick_vote_count !=
-                    kick_vote_count)
-                {
-                    this->squad.squad_members[i].kick_vote_count =
-                        kick_vote_count;
-                    sprintf(this->squad.squad_members[i].kick_text, "%u/%u",
-                            kick_vote_count, RR_SQUAD_MEMBER_COUNT - 1);
-                    if (this->kick_vote_pos == i)
-                        rr_ui_set_background(
-                            this->squad.squad_members[i].kick_text_el,
-                            0xffff4444);
-                    else
-                        rr_ui_set_background(
-                            this->squad.squad_members[i].kick_text_el,
-                            0xffffffff);
-                }
-                uint32_t level = proto_bug_read_varuint(&encoder, "level");
-                if (this->squad.squad_members[i].level != level)
-                {
-                    float health = 200 * pow(1.0256, level - 1);
-                    float damage = 0.1 * health;
-                    this->squad.squad_members[i].level = level;
-                    sprintf(this->squad.squad_members[i].level_text,
-                            "%u", level);
-                    rr_sprintf(this->squad.squad_members[i].health_text,
-                               health);
-                    rr_sprintf(this->squad.squad_members[i].damage_text,
-                               damage);
-                }
-                proto_bug_read_string(&encoder,
-                                      this->squad.squad_members[i].nickname, 16,
-                                      "nickname");
-                for (uint32_t j = 0; j < RR_MAX_SLOT_COUNT * 2; ++j)
-                {
-                    this->squad.squad_members[i].loadout[j].id =
-                        proto_bug_read_uint8(&encoder, "id");
-                    this->squad.squad_members[i].loadout[j].rarity =
-                        proto_bug_read_uint8(&encoder, "rar");
-                }
-            }
-            this->squad.squad_index = proto_bug_read_uint8(&encoder, "sqidx");
-            this->squad.squad_owner = proto_bug_read_uint8(&encoder, "sqown");
-            this->squad.squad_pos = proto_bug_read_uint8(&encoder, "sqpos");
-            this->squad.squad_private =
-                proto_bug_read_uint8(&encoder, "private");
-            this->squad.squad_expose_code =
-                proto_bug_read_uint8(&encoder, "expose_code");
-            this->selected_biome = proto_bug_read_uint8(&encoder, "biome");
-            proto_bug_read_string(&encoder, this->squad.squad_code, 16,
-                                  "squad code");
-            // this->is_dev =
-            //     this->squad.squad_members[this->squad.squad_pos].is_dev;
-            this->afk = proto_bug_read_uint8(&encoder, "afk");
-            if (proto_bug_read_uint8(&encoder, "in game") == 1)
-            {
-                if (!this->simulation_ready)
-                {
-                    rr_simulation_init(this->simulation);
-                    rr_simulation_init(this->deletion_simulation);
-                    rr_particle_manager_clear(&this->default_particle_manager);
-                    rr_particle_manager_clear(
-                        &this->foreground_particle_manager);
-                    rr_write_dev_cheat_packets(this, 1);
-                    this->simulation_ready = 1;
-                }
-                rr_simulation_read_binary(this, &encoder);
-            }
-            else
-            {
-                if (this->simulation_ready)
-                {
-                    rr_simulation_init(this->simulation);
-                    rr_particle_manager_clear(&this->default_particle_manager);
-                    rr_particle_manager_clear(
-                        &this->foreground_particle_manager);
-                }
-                this->simulation_ready = 0;
-                proto_bug_init(&encoder, RR_OUTGOING_PACKET);
-                proto_bug_write_uint8(&encoder, this->socket.quick_verification, "qv");
-                proto_bug_write_uint8(&encoder, rr_serverbound_squad_update,
-                                      "header");
-                proto_bug_write_string(&encoder, this->cache.nickname, 16,
-                                       "nickname");
-                proto_bug_write_uint8(&encoder, this->slots_unlocked,
-                                      "loadout count");
-                for (uint32_t i = 0; i < this->slots_unlocked; ++i)
-                {
-                    proto_bug_write_uint8(&encoder, this->cache.loadout[i].id,
-                                          "id");
-                    proto_bug_write_uint8(
-                        &encoder, this->cache.loadout[i].rarity, "rarity");
-                    proto_bug_write_uint8(
-                        &encoder,
-                        this->cache.loadout[i + RR_MAX_SLOT_COUNT].id, "id");
-                    proto_bug_write_uint8(
-                        &encoder,
-                        this->cache.loadout[i + RR_MAX_SLOT_COUNT].rarity,
-                        "rarity");
-                }
-                rr_websocket_send(&this->socket,
-                                  encoder.current - encoder.start);
-            }
+            proto_bug_init_deferred(&encoder, data);
+            read_clientbound_message(this, &encoder);
             break;
         }
-        case rr_clientbound_squad_dump:
+        // the per tick messages come together, each prefixed by its size
+        while (encoder.current < (uint8_t *)data + size)
         {
-            this->is_dev = proto_bug_read_uint8(&encoder, "is_dev");
-            this->kick_vote_pos = proto_bug_read_uint8(&encoder, "kick vote");
-            for (uint32_t s = 0; s < RR_SQUAD_COUNT; ++s)
-            {
-                struct rr_game_squad *squad = &this->other_squads[s];
-                for (uint32_t i = 0; i < RR_SQUAD_MEMBER_COUNT; ++i)
-                {
-                    squad->squad_members[i].in_use =
-                        proto_bug_read_uint8(&encoder, "bitbit");
-                    if (squad->squad_members[i].in_use == 0)
-                        continue;
-                    squad->squad_members[i].playing =
-                        proto_bug_read_uint8(&encoder, "ready");
-                    squad->squad_members[i].disconnected =
-                        proto_bug_read_uint8(&encoder, "disconnected");
-                    squad->squad_members[i].blocked =
-                        proto_bug_read_uint8(&encoder, "blocked");
-                    squad->squad_members[i].is_dev =
-                        proto_bug_read_uint8(&encoder, "is_dev");
-                    uint8_t kick_vote_count =
-                        proto_bug_read_uint8(&encoder, "kick votes");
-                    if (squad->squad_members[i].kick_vote_count !=
-                        kick_vote_count)
-                    {
-                        squad->squad_members[i].kick_vote_count =
-                            kick_vote_count;
-                        sprintf(squad->squad_members[i].kick_text, "%u/%u",
-                                kick_vote_count, RR_SQUAD_MEMBER_COUNT - 1);
-                        if (this->joined_squad &&
-                            this->squad.squad_index == s &&
-                            this->kick_vote_pos == i)
-                            rr_ui_set_background(
-                                squad->squad_members[i].kick_text_el,
-                                0xffff4444);
-                        else
-                            rr_ui_set_background(
-                                squad->squad_members[i].kick_text_el,
-                                0xffffffff);
-                    }
-                    uint32_t level = proto_bug_read_varuint(&encoder, "level");
-                    if (squad->squad_members[i].level != level)
-                    {
-                        float health = 200 * pow(1.0256, level - 1);
-                        float damage = 0.1 * health;
-                        squad->squad_members[i].level = level;
-                        sprintf(squad->squad_members[i].level_text,
-                                "%u", level);
-                        rr_sprintf(squad->squad_members[i].health_text, health);
-                        rr_sprintf(squad->squad_members[i].damage_text, damage);
-                    }
-                    proto_bug_read_string(&encoder,
-                                          squad->squad_members[i].nickname, 16,
-                                          "nickname");
-                    for (uint32_t j = 0; j < RR_MAX_SLOT_COUNT * 2; ++j)
-                    {
-                        squad->squad_members[i].loadout[j].id =
-                            proto_bug_read_uint8(&encoder, "id");
-                        squad->squad_members[i].loadout[j].rarity =
-                            proto_bug_read_uint8(&encoder, "rar");
-                    }
-                }
-                squad->squad_index = s;
-                squad->squad_owner = proto_bug_read_uint8(&encoder, "sqown");
-                squad->squad_private =
-                    proto_bug_read_uint8(&encoder, "private");
-                squad->squad_expose_code =
-                    proto_bug_read_uint8(&encoder, "expose_code");
-                this->selected_biome = proto_bug_read_uint8(&encoder, "biome");
-                proto_bug_read_string(&encoder, squad->squad_code, 16,
-                                      "squad code");
-            }
-            break;
-        }
-        case rr_clientbound_animation_update:
-        {
-            while (proto_bug_read_uint8(&encoder, "continue"))
-            {
-                struct rr_simulation_animation *particle;
-                uint8_t type = proto_bug_read_uint8(&encoder, "ani type");
-                if (type != rr_animation_type_chat)
-                    particle =
-                        rr_particle_alloc(&this->foreground_particle_manager,
-                                          type);
-                switch (type)
-                {
-                case rr_animation_type_lightningbolt:
-                    particle->length =
-                        proto_bug_read_uint8(&encoder, "ani length");
-                    for (uint32_t i = 0; i < particle->length; ++i)
-                    {
-                        particle->points[i].x =
-                            proto_bug_read_float32(&encoder, "ani x");
-                        particle->points[i].y =
-                            proto_bug_read_float32(&encoder, "ani y");
-                    }
-                    particle->opacity = 0.8;
-                    particle->disappearance = 6;
-                    break;
-                case rr_animation_type_damagenumber:
-                {
-                    particle->x = proto_bug_read_float32(&encoder, "ani x");
-                    particle->y = proto_bug_read_float32(&encoder, "ani y");
-                    particle->velocity.x = (rr_frand() - 0.5) * 25;
-                    particle->velocity.y = -15 + rr_frand() * 5;
-                    particle->acceleration.y = 0.75;
-                    particle->friction = 0.9;
-                    particle->damage =
-                        proto_bug_read_varuint(&encoder, "damage");
-                    switch (proto_bug_read_uint8(&encoder, "color type"))
-                    {
-                    case rr_animation_color_type_damage:
-                        particle->color = 0xffff4444;
-                        break;
-                    case rr_animation_color_type_heal:
-                        particle->color = 0xffffff44;
-                        break;
-                    case rr_animation_color_type_uranium:
-                        particle->color = 0xff63bf2e;
-                        break;
-                    case rr_animation_color_type_fireball:
-                        particle->color = 0xffce5d0b;
-                        break;
-                    case rr_animation_color_type_lightning:
-                        particle->color = 0xffccccfc;
-                        break;
-                    }
-                    particle->opacity = 1;
-                    particle->disappearance = 6;
-                    break;
-                }
-                case rr_animation_type_chat:
-                    if (this->chat.at < 9)
-                        this->chat.at++;
-                    else
-                    {
-                        for (uint8_t i = 0; i < 9; i++)
-                            this->chat.messages[i] = this->chat.messages[i + 1];
-                    }
-                    struct rr_game_chat_message *message = &this->chat.messages[this->chat.at];
-                    proto_bug_read_string(&encoder, message->sender_name, 64, "name");
-                    proto_bug_read_string(&encoder, message->message, 64, "chat");
-                    sprintf(message->text, "%s: %s", message->sender_name, message->message);
-                    break;
-                case rr_animation_type_area_damage:
-                    particle->x = proto_bug_read_float32(&encoder, "ani x");
-                    particle->y = proto_bug_read_float32(&encoder, "ani y");
-                    particle->size = proto_bug_read_float32(&encoder, "size");
-                    switch (proto_bug_read_uint8(&encoder, "color type"))
-                    {
-                    case rr_animation_color_type_uranium:
-                        particle->color = 0x2063bf2e;
-                        break;
-                    case rr_animation_color_type_fireball:
-                        particle->color = 0x80ce5d0b;
-                        break;
-                    }
-                    particle->opacity = 1;
-                    particle->disappearance = 10 * sqrtf(500 / particle->size);
-                    break;
-                default:
-                    break;
-                }
-            }
-            break;
-        }
-        case rr_clientbound_squad_fail:
-            this->socket_error =
-                3 + proto_bug_read_uint8(&encoder, "fail type");
-            if (this->simulation_ready)
-            {
-                rr_simulation_init(this->simulation);
-                rr_particle_manager_clear(&this->default_particle_manager);
-                rr_particle_manager_clear(&this->foreground_particle_manager);
-            }
-            this->simulation_ready = 0;
-            this->joined_squad = 0;
-            break;
-        case rr_clientbound_squad_leave:
-            this->joined_squad = 0;
-            break;
-        case rr_clientbound_account_result:
-            rr_game_read_account(this, &encoder);
-            break;
-        case rr_clientbound_craft_result:
-        {
-            this->crafting_data.crafting_id =
-                proto_bug_read_uint8(&encoder, "craft id");
-            this->crafting_data.crafting_rarity =
-                proto_bug_read_uint8(&encoder, "craft rarity");
-            this->crafting_data.temp_successes =
-                proto_bug_read_varuint(&encoder, "success count");
-            this->crafting_data.temp_fails =
-                proto_bug_read_varuint(&encoder, "fail count");
-            this->crafting_data.temp_attempts =
-                proto_bug_read_varuint(&encoder, "attempts");
-            this->crafting_data.temp_xp =
-                proto_bug_read_float64(&encoder, "craft xp");
-            this->crafting_data.animation =
-                powf(1.25, this->crafting_data.crafting_rarity);
-            if (this->crafting_data.temp_successes == 0)
-                this->crafting_data.animation *=
-                    (5 - (this->crafting_data.count -
-                          this->crafting_data.temp_fails)) / 5.0f;
-            break;
-        }
-        default:
-            RR_UNREACHABLE("how'd this happen");
+            uint32_t length = proto_bug_read_uint32(&encoder, "bundle size");
+            struct proto_bug message;
+            proto_bug_init_deferred(&message, encoder.current);
+            read_clientbound_message(this, &message);
+            encoder.current += length;
         }
         break;
     }
@@ -1628,7 +1650,6 @@ void rr_game_tick(struct rr_game *this, float delta)
         }
 #undef GRID_SIZE
         struct rr_simulation *sim = this->simulation;
-        rr_simulation_create_component_vectors(sim);
         if (rr_frand() < 0.05)
         {
             EntityIdx petal_id = rr_simulation_alloc_entity(sim);
@@ -1699,10 +1720,11 @@ void rr_game_tick(struct rr_game *this, float delta)
             rr_renderer_context_state_free(this->renderer, &state2);
             if (physical->lerp_x > 1200)
             {
-                __rr_simulation_pending_deletion_free_components(
-                    this->simulation->petal_vector[i], sim);
-                __rr_simulation_pending_deletion_unset_entity(
-                    this->simulation->petal_vector[i], sim);
+                EntityIdx petal = this->simulation->petal_vector[i];
+                __rr_simulation_pending_deletion_free_components(petal, sim);
+                __rr_simulation_pending_deletion_unset_entity(petal, sim);
+                // the last petal was swapped into this spot
+                --i;
             }
         }
         rr_system_particle_render_tick(this, &this->foreground_particle_manager,
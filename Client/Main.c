@@ -364,9 +364,9 @@ int main()
     static struct rr_game game;
     static struct rr_renderer renderer;
     static struct rr_input_data input_data;
-    struct rr_simulation *simulation = malloc(sizeof *simulation);
+    struct rr_simulation *simulation = calloc(1, sizeof *simulation);
     struct rr_simulation *deletion_simulation =
-        malloc(sizeof *deletion_simulation);
+        calloc(1, sizeof *deletion_simulation);
     rr_main_loop(&game);
 
     rr_renderer_init(&renderer);
@@ -30,6 +30,7 @@
 
 void rr_simulation_init(struct rr_simulation *this)
 {
+    rr_simulation_free_component_pools(this);
     memset(this, 0, sizeof *this);
 }
 
@@ -83,7 +84,7 @@ void rr_simulation_read_binary(struct rr_game *game, struct proto_bug *encoder)
         uint32_t component_flags =
             proto_bug_read_varuint(encoder, "entity component flags");
 
-        if (is_creation)
+        if (is_creation == 1)
         {
 // #ifndef RIVET_BUILD
 //             printf("create entity with id %d, components %d\n", id,
@@ -100,6 +101,13 @@ void rr_simulation_read_binary(struct rr_game *game, struct proto_bug *encoder)
             printf(
                 "protocol error: entity %d misaligned: expected %d but got %d",
                 id, this->entity_tracker[id] >> 1, component_flags >> 1);
+        // full state for an entity we missed updates to, positions are sent
+        // absolute instead of as deltas
+        else if (is_creation == 2 && rr_simulation_has_physical(this, id))
+        {
+            rr_simulation_get_physical(this, id)->x = 0;
+            rr_simulation_get_physical(this, id)->y = 0;
+        }
 
 #define XX(COMPONENT, ID)                                                      \
     if (component_flags & (1 << ID))                                           \
@@ -118,7 +126,6 @@ void rr_simulation_read_binary(struct rr_game *game, struct proto_bug *encoder)
 
 void rr_simulation_tick(struct rr_simulation *this, float delta)
 {
-    rr_simulation_create_component_vectors(this);
     rr_system_interpolation_tick(this, delta);
 }
 
@@ -133,7 +140,6 @@ void rr_deletion_simulation_tick(struct rr_simulation *this, float delta)
                                RR_BITSET_ROUND(RR_MAX_ENTITY_COUNT),
                            this, __rr_simulation_pending_deletion_unset_entity);
     memset(this->pending_deletions, 0, RR_BITSET_ROUND(RR_MAX_ENTITY_COUNT));
-    rr_simulation_create_component_vectors(this);
     rr_system_deletion_animation_tick(this, delta);
 }
 
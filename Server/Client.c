@@ -16,7 +16,6 @@
 
 #include <Server/Client.h>
 
-#include <libwebsockets.h>
 #include <math.h>
 #include <pthread.h>
 #include <stdio.h>
@@ -92,38 +91,37 @@ void rr_server_client_create_flower(struct rr_server_client *this)
         rr_binary_encoder_write_uint8(&encoder, slot->rarity);
     }
     rr_binary_encoder_write_uint8(&encoder, 0);
-    lws_write(this->server->api_client, encoder.start,
-              encoder.at - encoder.start, LWS_WRITE_BINARY);
+    rr_network_write_api(&this->server->network, encoder.start,
+                         encoder.at - encoder.start);
 }
 
-void rr_server_client_write_message(struct rr_server_client *this,
-                                    uint8_t *data, uint64_t size)
+void rr_server_client_encrypt_message(struct rr_server_client *this,
+                                      uint8_t *data, uint64_t size)
 {
-    if (this->message_length++ >= 512)
-    {
-        this->pending_kick = 1;
-        lws_callback_on_writable(this->socket_handle);
-        return;
-    }
     if (this->received_first_packet)
     {
         this->clientbound_encryption_key =
             rr_get_hash(this->clientbound_encryption_key);
         rr_encrypt(data, size, this->clientbound_encryption_key);
     }
-    struct rr_server_client_message *message = malloc(sizeof *message);
-    uint8_t *packet = malloc(LWS_PRE + size);
-    memcpy(packet + LWS_PRE, data, size);
-    message->next = NULL;
-    message->len = size;
-    message->packet = packet;
-    if (this->message_root == NULL)
-        this->message_root = message;
-    else
-        this->message_at->next = message;
-    this->message_at = message;
-    lws_callback_on_writable(this->socket_handle);
-    // lws_write(this->socket_handle, data, size, LWS_WRITE_BINARY);
+}
+
+void rr_server_client_queue_message(struct rr_server_client *this,
+                                    uint8_t *data, uint64_t size)
+{
+    if (this->connection == RR_NULL_CONNECTION)
+        return;
+    // a dropped frame breaks the key ratchet so the client has to go
+    if (!rr_network_write(&this->server->network, this->connection, data,
+                          size))
+        this->pending_kick = 1;
+}
+
+void rr_server_client_write_message(struct rr_server_client *this,
+                                    uint8_t *data, uint64_t size)
+{
+    rr_server_client_encrypt_message(this, data, size);
+    rr_server_client_queue_message(this, data, size);
 }
 
 void rr_server_client_write_account(struct rr_server_client *client)
@@ -342,6 +340,6 @@ void rr_server_client_write_to_api(struct rr_server_client *this)
                                             this->mob_gallery[id][rarity]);
         }
     rr_binary_encoder_write_uint8(&encoder, 0);
-    lws_write(this->server->api_client, encoder.start,
-              encoder.at - encoder.start, LWS_WRITE_BINARY);
+    rr_network_write_api(&this->server->network, encoder.start,
+                         encoder.at - encoder.start);
 }
\ No newline at end of file
@@ -31,13 +31,6 @@
 
 struct rr_binary_encoder;
 
-struct rr_server_client_message
-{
-    struct rr_server_client_message *next;
-    uint64_t len;
-    uint8_t *packet;
-};
-
 struct rr_server_client_dev_cheats
 {
     uint8_t invisible : 1;
@@ -57,11 +50,8 @@ struct rr_server_client
     uint64_t serverbound_encryption_key;
     uint64_t requested_verification;
     uint8_t quick_verification;
-    uint64_t message_length;
     struct rr_server *server;
-    struct lws *socket_handle;
-    struct rr_server_client_message *message_root;
-    struct rr_server_client_message *message_at;
+    uint32_t connection;
     struct rr_component_player_info *player_info;
     struct rr_server_client_dev_cheats dev_cheats;
     double experience;
@@ -78,6 +68,17 @@ struct rr_server_client
     uint32_t afk_ticks;
     uint8_t joined_squad_before[RR_BITSET_ROUND(RR_SQUAD_COUNT)];
     uint8_t blocked_clients[RR_BITSET_ROUND(RR_MAX_CLIENT_COUNT)];
+    // update rate lod state per entity, see rr_simulation_write_binary
+    uint8_t update_priority[RR_MAX_ENTITY_COUNT];
+    uint8_t update_stale[RR_BITSET_ROUND(RR_MAX_ENTITY_COUNT)];
+    // entities that died while this client's updates were held back, the
+    // next update deletes them
+    uint8_t update_deleted[RR_BITSET_ROUND(RR_MAX_ENTITY_COUNT)];
+    // deletion type each of those gets, decided when it was spotted
+    uint8_t update_deletion_type[RR_MAX_ENTITY_COUNT];
+    // ring position after the last per-tick frames, until the network thread
+    // gets past it the client is behind and gets no new ones
+    uint64_t tick_frames_end;
     uint8_t squad_pos;
     uint8_t squad;
     uint8_t checkpoint;
@@ -96,6 +97,12 @@ void rr_server_client_create_flower(struct rr_server_client *);
 
 void rr_server_client_write_message(struct rr_server_client *, uint8_t *,
                                     uint64_t);
+// The two halves of rr_server_client_write_message. Encryption only touches
+// the client itself so it may run off the main thread, queueing may not.
+void rr_server_client_encrypt_message(struct rr_server_client *, uint8_t *,
+                                      uint64_t);
+void rr_server_client_queue_message(struct rr_server_client *, uint8_t *,
+                                    uint64_t);
 void rr_server_client_write_account(struct rr_server_client *);
 void rr_server_client_craft_petal(struct rr_server_client *, struct rr_server *,
                                   uint8_t, uint8_t, uint32_t);
@@ -19,7 +19,9 @@
 #include <Server/Simulation.h>
 #include <Server/Waves.h>
 
+#include <assert.h>
 #include <math.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -58,7 +60,7 @@ EntityIdx rr_simulation_alloc_player(struct rr_simulation *this,
     rr_component_physical_set_radius(physical, 25.0f);
     physical->mass = 10;
     physical->arena = arena_id;
-    physical->friction = 0.75;
+    *rr_simulation_get_friction(this, flower_id) = 0.75;
     if (player_info->client->dev)
         rr_component_physical_set_angle(physical, M_PI);
     // easter egg
@@ -109,7 +111,7 @@ EntityIdx rr_simulation_alloc_petal(struct rr_simulation *this, EntityIdx arena,
     rr_component_physical_set_y(physical, y);
     physical->arena = arena;
     physical->mass = 5;
-    physical->friction = 0.75;
+    *rr_simulation_get_friction(this, petal_id) = 0.75;
     float scale_h = data->scale[rarity].health;
     float scale_d = data->scale[rarity].damage;
     if (id == rr_petal_id_club)
@@ -172,7 +174,7 @@ static EntityIdx rr_simulation_alloc_mob_non_recursive(
     rr_component_physical_set_x(physical, x);
     rr_component_physical_set_y(physical, y);
     physical->arena = arena_id;
-    physical->friction = 0.75;
+    *rr_simulation_get_friction(this, entity) = 0.75;
     physical->mass = 10.0f * powf(2, rarity_id + 1);
     rr_component_health_set_max_health(health,
                                        mob_data->health * rarity_scale->health);
@@ -218,7 +220,7 @@ EntityIdx rr_simulation_alloc_mob(struct rr_simulation *this,
     rr_component_physical_set_x(physical, x);
     rr_component_physical_set_y(physical, y);
     physical->arena = arena_id;
-    physical->friction = 0.75;
+    *rr_simulation_get_friction(this, entity) = 0.75;
     physical->mass = 10.0f * powf(2, rarity_id + 1);
     physical->slow_resist = rr_fclamp(0.2 * (rarity_scale->radius - 1), 0, 1);
     if (mob_id == rr_mob_id_meteor)
@@ -302,20 +304,60 @@ EntityIdx rr_simulation_alloc_mob(struct rr_simulation *this,
 
 EntityIdx rr_simulation_alloc_entity(struct rr_simulation *this)
 {
-    for (EntityIdx i = 1; i < RR_MAX_ENTITY_COUNT; i++)
+    struct rr_simulation_entity_allocator *allocator = &this->entity_allocator;
+    EntityIdx entity;
+    if (allocator->free_count > 0)
     {
-        if (!rr_simulation_has_entity(this, i))
-        {
-            if (rr_bitset_get_bit(this->deleted_last_tick, i))
-                continue;
-            this->entity_tracker[i] = 1;
-            ++this->entity_hash_tracker[i];
+        entity = allocator->free[allocator->free_start];
+        allocator->free_start =
+            (allocator->free_start + 1) % RR_MAX_ENTITY_COUNT;
+        --allocator->free_count;
+        ++allocator->recycled_allocations;
+    }
+    else if (allocator->fresh_count + 1 < RR_MAX_ENTITY_COUNT)
+        entity = ++allocator->fresh_count;
+    else
+        RR_UNREACHABLE("ran out of entity ids");
+    assert(!rr_simulation_has_entity(this, entity));
+    this->entity_tracker[entity] = 1;
+    ++this->entity_hash_tracker[entity];
+    ++allocator->allocations;
+    if (++allocator->live_count > allocator->peak_live_count)
+        allocator->peak_live_count = allocator->live_count;
 #ifndef NDEBUG
-            printf("<rr_simulation::entity_create::%d>\n", i);
+    printf("<rr_simulation::entity_create::%d>\n", entity);
 #endif
-            return i;
-        }
-    }
+    return entity;
+}
 
-    RR_UNREACHABLE("ran out of entity ids");
+void rr_simulation_quarantine_entity(struct rr_simulation *this,
+                                     EntityIdx entity)
+{
+    struct rr_simulation_entity_allocator *allocator = &this->entity_allocator;
+    allocator->quarantine[allocator->quarantine_count++] = entity;
+    --allocator->live_count;
+    ++allocator->releases;
+}
+
+void rr_simulation_release_quarantined_entities(struct rr_simulation *this)
+{
+    struct rr_simulation_entity_allocator *allocator = &this->entity_allocator;
+    for (uint32_t i = 0; i < allocator->quarantine_count; ++i)
+        allocator->free[(allocator->free_start + allocator->free_count++) %
+                        RR_MAX_ENTITY_COUNT] = allocator->quarantine[i];
+    allocator->quarantine_count = 0;
+    if (++allocator->tick_count < RR_ENTITY_ALLOCATION_REPORT_INTERVAL)
+        return;
+    fprintf(stderr,
+            "entity ids over %u ticks: %u allocated (%u recycled), %u freed, "
+            "%u live, %u peak, %u of %u ever used\n",
+            allocator->tick_count, allocator->allocations,
+            allocator->recycled_allocations, allocator->releases,
+            allocator->live_count, allocator->peak_live_count,
+            allocator->fresh_count, RR_MAX_ENTITY_COUNT - 1);
+    allocator->allocations = 0;
+    allocator->recycled_allocations = 0;
+    allocator->releases = 0;
+    allocator->peak_live_count = allocator->live_count;
+    allocator->tick_count = 0;
 }
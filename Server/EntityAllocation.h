@@ -16,9 +16,20 @@
 
 #pragma once
 
+#include <Server/TickScheduler.h>
 #include <Shared/SimulationCommon.h>
 
+#ifndef RR_ENTITY_ALLOCATION_REPORT_INTERVAL
+#define RR_ENTITY_ALLOCATION_REPORT_INTERVAL (60 * RR_SERVER_TICK_RATE)
+#endif
+
 EntityIdx rr_simulation_alloc_entity(struct rr_simulation *);
+// Called for every entity unset at the end of a tick
+void rr_simulation_quarantine_entity(struct rr_simulation *, EntityIdx);
+// Makes the ids quarantined last tick allocatable again and reports
+// allocation pressure every RR_ENTITY_ALLOCATION_REPORT_INTERVAL ticks. Call
+// once per tick before quarantining that tick's deletions
+void rr_simulation_release_quarantined_entities(struct rr_simulation *);
 EntityIdx rr_simulation_alloc_petal(struct rr_simulation *, EntityIdx, float,
                                     float, uint8_t, uint8_t, EntityIdx);
 EntityIdx rr_simulation_alloc_mob(struct rr_simulation *, EntityIdx, float,
@@ -23,6 +23,11 @@
 
 #define MAX_ENTITY_CHOOSE_COUNT 256
 
+#define ENEMY_COMPONENTS                                                       \
+    (rr_component_mask_flower | rr_component_mask_mob |                        \
+     rr_component_mask_petal)
+#define FRIEND_COMPONENTS (rr_component_mask_flower | rr_component_mask_mob)
+
 struct entity_finder_captures
 {
     struct rr_simulation *simulation;
@@ -55,21 +60,16 @@ void shg_cb_enemy(EntityIdx potential, void *_captures)
 {
     struct entity_finder_captures *captures = _captures;
     struct rr_simulation *simulation = captures->simulation;
-    uint8_t allow =
-        !rr_simulation_has_arena(simulation, potential) &&
-        (rr_simulation_has_flower(simulation, potential) ||
-         rr_simulation_has_mob(simulation, potential) ||
-         (rr_simulation_has_petal(simulation, potential) &&
-          (rr_simulation_get_petal(simulation, potential)->id == rr_petal_id_seed ||
-           rr_simulation_get_petal(simulation, potential)->id == rr_petal_id_nest) &&
-          rr_simulation_get_petal(simulation, potential)->detached));
-    if (!allow)
+    // the query already limits this to enemy flowers, mobs and petals
+    if (rr_simulation_has_petal(simulation, potential) &&
+        !((rr_simulation_get_petal(simulation, potential)->id ==
+               rr_petal_id_seed ||
+           rr_simulation_get_petal(simulation, potential)->id ==
+               rr_petal_id_nest) &&
+          rr_simulation_get_petal(simulation, potential)->detached))
         return;
     if (dev_cheat_enabled(simulation, potential, no_aggro))
         return;
-    if (is_same_team(rr_simulation_get_relations(simulation, potential)->team,
-                     captures->seeker_team))
-        return;
     if (rr_simulation_get_health(simulation, potential)->health == 0)
         return;
     struct rr_component_physical *t_physical =
@@ -94,13 +94,6 @@ void shg_cb_friend(EntityIdx potential, void *_captures)
 {
     struct entity_finder_captures *captures = _captures;
     struct rr_simulation *simulation = captures->simulation;
-    if (!rr_simulation_has_mob(simulation, potential) &&
-            !rr_simulation_has_flower(simulation, potential) ||
-        rr_simulation_has_arena(simulation, potential))
-        return;
-    if (!is_same_team(rr_simulation_get_relations(simulation, potential)->team,
-                      captures->seeker_team))
-        return;
     if (rr_simulation_get_health(simulation, potential)->health == 0)
         return;
     struct rr_component_physical *t_physical =
@@ -123,21 +116,16 @@ void shg_cb_rand_enemy(EntityIdx potential, void *_captures)
 {
     struct entity_chooser_captures *captures = _captures;
     struct rr_simulation *simulation = captures->simulation;
-    uint8_t allow =
-        !rr_simulation_has_arena(simulation, potential) &&
-        (rr_simulation_has_flower(simulation, potential) ||
-         rr_simulation_has_mob(simulation, potential) ||
-         (rr_simulation_has_petal(simulation, potential) &&
-          (rr_simulation_get_petal(simulation, potential)->id == rr_petal_id_seed ||
-           rr_simulation_get_petal(simulation, potential)->id == rr_petal_id_nest) &&
-          rr_simulation_get_petal(simulation, potential)->detached));
-    if (!allow)
+    // the query already limits this to enemy flowers, mobs and petals
+    if (rr_simulation_has_petal(simulation, potential) &&
+        !((rr_simulation_get_petal(simulation, potential)->id ==
+               rr_petal_id_seed ||
+           rr_simulation_get_petal(simulation, potential)->id ==
+               rr_petal_id_nest) &&
+          rr_simulation_get_petal(simulation, potential)->detached))
         return;
     if (dev_cheat_enabled(simulation, potential, no_aggro))
         return;
-    if (is_same_team(rr_simulation_get_relations(simulation, potential)->team,
-                     captures->seeker_team))
-        return;
     if (rr_simulation_get_health(simulation, potential)->health == 0)
         return;
     struct rr_component_physical *t_physical =
@@ -215,8 +203,11 @@ EntityIdx rr_simulation_find_nearest_enemy_custom_pos(
     shg_captures.seeker_team = relations->team;
     struct rr_spatial_hash *shg =
         &rr_simulation_get_arena(simulation, physical->arena)->spatial_hash;
-    rr_spatial_hash_query(shg, x, y, min_dist, min_dist, &shg_captures,
-                          shg_cb_enemy);
+    struct rr_spatial_hash_filter shg_filter = {
+        ENEMY_COMPONENTS, rr_component_mask_arena, relations->team,
+        rr_spatial_hash_team_other};
+    rr_spatial_hash_query_circle(shg, x, y, min_dist, &shg_filter,
+                                 &shg_captures, shg_cb_enemy);
 
     return shg_captures.closest;
 }
@@ -256,8 +247,11 @@ EntityIdx rr_simulation_find_nearest_friend_custom_pos(
     shg_captures.seeker_team = relations->team;
     struct rr_spatial_hash *shg =
         &rr_simulation_get_arena(simulation, physical->arena)->spatial_hash;
-    rr_spatial_hash_query(shg, x, y, min_dist, min_dist, &shg_captures,
-                          shg_cb_friend);
+    struct rr_spatial_hash_filter shg_filter = {
+        FRIEND_COMPONENTS, rr_component_mask_arena, relations->team,
+        rr_spatial_hash_team_same};
+    rr_spatial_hash_query_circle(shg, x, y, min_dist, &shg_filter,
+                                 &shg_captures, shg_cb_friend);
 
     return shg_captures.closest;
 }
@@ -296,8 +290,11 @@ EntityIdx rr_simulation_choose_nearby_enemy_custom_pos(
     shg_captures.potential_count = 0;
     struct rr_spatial_hash *shg =
         &rr_simulation_get_arena(simulation, physical->arena)->spatial_hash;
-    rr_spatial_hash_query(shg, x, y, min_dist, min_dist, &shg_captures,
-                          shg_cb_rand_enemy);
+    struct rr_spatial_hash_filter shg_filter = {
+        ENEMY_COMPONENTS, rr_component_mask_arena, relations->team,
+        rr_spatial_hash_team_other};
+    rr_spatial_hash_query_circle(shg, x, y, min_dist, &shg_filter,
+                                 &shg_captures, shg_cb_rand_enemy);
 
     float sum = 0;
     for (uint32_t i = 0; i < shg_captures.potential_count; ++i)
@@ -134,7 +134,7 @@ void tick_idle_move_default(EntityIdx entity, struct rr_simulation *simulation)
     }
     struct rr_vector accel;
     rr_vector_from_polar(&accel, 1.0f, physical->angle);
-    rr_vector_add(&physical->acceleration, &accel);
+    rr_vector_add(rr_simulation_get_acceleration(simulation, entity), &accel);
 }
 
 void tick_idle_move_sinusoid(EntityIdx entity, struct rr_simulation *simulation,
@@ -147,7 +147,7 @@ void tick_idle_move_sinusoid(EntityIdx entity, struct rr_simulation *simulation,
     struct rr_vector accel;
     rr_component_physical_set_angle(physical, physical->bearing_angle + add);
     rr_vector_from_polar(&accel, speed, physical->angle);
-    rr_vector_add(&physical->acceleration, &accel);
+    rr_vector_add(rr_simulation_get_acceleration(simulation, entity), &accel);
 }
 
 uint8_t tick_summon_return_to_owner(EntityIdx entity,
@@ -183,7 +183,8 @@ uint8_t tick_summon_return_to_owner(EntityIdx entity,
     {
         struct rr_vector accel = delta;
         rr_vector_set_magnitude(&accel, RR_PLAYER_SPEED * 1.2);
-        rr_vector_add(&physical->acceleration, &accel);
+        rr_vector_add(rr_simulation_get_acceleration(simulation, entity),
+                      &accel);
         rr_component_physical_set_angle(physical, rr_vector_theta(&accel));
         ai->target_entity = RR_NULL_ENTITY;
         return 1;
@@ -193,7 +194,8 @@ uint8_t tick_summon_return_to_owner(EntityIdx entity,
         ai->ai_state = rr_ai_state_returning_to_owner;
         struct rr_vector accel = delta;
         rr_vector_set_magnitude(&accel, RR_PLAYER_SPEED * 1.2);
-        rr_vector_add(&physical->acceleration, &accel);
+        rr_vector_add(rr_simulation_get_acceleration(simulation, entity),
+                      &accel);
         rr_component_physical_set_angle(physical, rr_vector_theta(&accel));
         ai->target_entity = RR_NULL_ENTITY;
         return 1;
@@ -60,7 +60,8 @@ void tick_ai_default(EntityIdx entity, struct rr_simulation *simulation,
             physical, rr_angle_lerp(physical->angle, target_angle, 0.4));
 
         rr_vector_from_polar(&accel, speed, physical->angle);
-        rr_vector_add(&physical->acceleration, &accel);
+        rr_vector_add(rr_simulation_get_acceleration(simulation, entity),
+                      &accel);
         ai->ticks_until_next_action = 2;
         break;
     }
@@ -105,8 +106,9 @@ void tick_ai_triceratops(EntityIdx entity, struct rr_simulation *simulation)
         struct rr_vector delta = {physical2->x, physical2->y};
         struct rr_vector target_pos = {physical->x, physical->y};
         rr_vector_sub(&delta, &target_pos);
-        struct rr_vector prediction =
-            predict(delta, physical2->velocity, ai->has_prediction * 15);
+        struct rr_vector prediction = predict(
+            delta, *rr_simulation_get_velocity(simulation, ai->target_entity),
+            ai->has_prediction * 15);
         rr_component_physical_set_angle(physical, rr_vector_theta(&prediction));
         break;
     }
@@ -126,15 +128,17 @@ void tick_ai_triceratops(EntityIdx entity, struct rr_simulation *simulation)
         struct rr_vector delta = {physical2->x, physical2->y};
         struct rr_vector target_pos = {physical->x, physical->y};
         rr_vector_sub(&delta, &target_pos);
-        struct rr_vector prediction =
-            predict(delta, physical2->velocity, ai->has_prediction * 15);
+        struct rr_vector prediction = predict(
+            delta, *rr_simulation_get_velocity(simulation, ai->target_entity),
+            ai->has_prediction * 15);
         float target_angle = rr_vector_theta(&prediction);
 
         rr_component_physical_set_angle(
             physical, rr_angle_lerp(physical->angle, target_angle, 0.25));
 
         rr_vector_from_polar(&accel, RR_PLAYER_SPEED * 1.3, physical->angle);
-        rr_vector_add(&physical->acceleration, &accel);
+        rr_vector_add(rr_simulation_get_acceleration(simulation, entity),
+                      &accel);
         break;
     }
     default:
@@ -178,7 +182,8 @@ void tick_ai_trex(EntityIdx entity, struct rr_simulation *simulation)
             physical, rr_angle_lerp(physical->angle, target_angle, 0.4));
 
         rr_vector_from_polar(&accel, RR_PLAYER_SPEED * 1.05, physical->angle);
-        rr_vector_add(&physical->acceleration, &accel);
+        rr_vector_add(rr_simulation_get_acceleration(simulation, entity),
+                      &accel);
         if (ai->ticks_until_next_action == 0)
         {
             if (rr_simulation_get_mob(simulation, entity)->rarity >=
@@ -263,18 +268,19 @@ void tick_ai_pteranodon(EntityIdx entity, struct rr_simulation *simulation)
         struct rr_vector delta = {physical2->x, physical2->y};
         struct rr_vector target_pos = {physical->x, physical->y};
         rr_vector_sub(&delta, &target_pos);
-        struct rr_vector prediction =
-            predict(delta, physical2->velocity,
-                    (ai->has_prediction ||
-                     rr_simulation_get_mob(simulation, entity)->rarity >=
-                         rr_rarity_id_exotic) *
-                        20); // make this less op
+        struct rr_vector prediction = predict(
+            delta, *rr_simulation_get_velocity(simulation, ai->target_entity),
+            (ai->has_prediction ||
+             rr_simulation_get_mob(simulation, entity)->rarity >=
+                 rr_rarity_id_exotic) *
+                20); // make this less op
         rr_component_physical_set_angle(physical, rr_vector_theta(&prediction));
         if (rr_vector_magnitude_cmp(&delta, 500) == 1)
         {
             struct rr_vector accel;
             rr_vector_from_polar(&accel, RR_PLAYER_SPEED, physical->angle);
-            rr_vector_add(&physical->acceleration, &accel);
+            rr_vector_add(rr_simulation_get_acceleration(simulation, entity),
+                          &accel);
         }
         if (ai->ticks_until_next_action == 0)
         {
@@ -301,11 +307,13 @@ void tick_ai_pteranodon(EntityIdx entity, struct rr_simulation *simulation)
             rr_component_physical_set_angle(physical2, physical->angle);
             rr_component_physical_set_radius(
                 physical2, 10 * RR_MOB_RARITY_SCALING[mob->rarity].radius);
-            physical2->friction = 0.45f;
+            *rr_simulation_get_friction(simulation, petal_id) = 0.45f;
             physical2->mass = 5.0f;
             physical2->knockback_scale = 2.5f * (mob->rarity + 1);
             physical2->bearing_angle = physical->angle;
-            rr_vector_from_polar(&physical2->velocity, 100, physical->angle);
+            rr_vector_from_polar(
+                rr_simulation_get_velocity(simulation, petal_id), 100,
+                physical->angle);
             rr_component_petal_set_detached(
                 rr_simulation_get_petal(simulation, petal_id), 1);
             rr_component_health_set_max_health(
@@ -316,7 +324,8 @@ void tick_ai_pteranodon(EntityIdx entity, struct rr_simulation *simulation)
             struct rr_vector recoil;
             rr_vector_from_polar(&recoil, -5,
                                  physical->angle); // recoil
-            rr_vector_add(&physical->acceleration, &recoil);
+            rr_vector_add(rr_simulation_get_acceleration(simulation, entity),
+                          &recoil);
         }
         break;
     }
@@ -328,15 +337,16 @@ void tick_ai_pteranodon(EntityIdx entity, struct rr_simulation *simulation)
         struct rr_vector delta = {physical2->x, physical2->y};
         struct rr_vector target_pos = {physical->x, physical->y};
         rr_vector_sub(&delta, &target_pos);
-        struct rr_vector prediction =
-            predict(delta, physical2->velocity,
-                    ai->has_prediction * 20); // make this less op
+        struct rr_vector prediction = predict(
+            delta, *rr_simulation_get_velocity(simulation, ai->target_entity),
+            ai->has_prediction * 20); // make this less op
         rr_component_physical_set_angle(physical, rr_vector_theta(&prediction));
         if (ai->ticks_until_next_action < 50)
         {
             struct rr_vector accel;
             rr_vector_from_polar(&accel, RR_PLAYER_SPEED * 2, physical->angle);
-            rr_vector_add(&physical->acceleration, &accel);
+            rr_vector_add(rr_simulation_get_acceleration(simulation, entity),
+                          &accel);
         }
         if (ai->ticks_until_next_action == 0)
         {
@@ -383,7 +393,8 @@ void tick_ai_pachycephalosaurus(EntityIdx entity,
         rr_component_physical_set_angle(physical, target_angle);
 
         rr_vector_from_polar(&accel, RR_PLAYER_SPEED, physical->angle);
-        rr_vector_add(&physical->acceleration, &accel);
+        rr_vector_add(rr_simulation_get_acceleration(simulation, entity),
+                      &accel);
         ai->ticks_until_next_action = 25;
         if (rr_vector_magnitude_cmp(&delta, 350) == -1)
             ai->ai_state = rr_ai_state_charging;
@@ -396,7 +407,8 @@ void tick_ai_pachycephalosaurus(EntityIdx entity,
             rr_simulation_get_physical(simulation, ai->target_entity);
 
         rr_vector_from_polar(&accel, RR_PLAYER_SPEED * 1.8, physical->angle);
-        rr_vector_add(&physical->acceleration, &accel);
+        rr_vector_add(rr_simulation_get_acceleration(simulation, entity),
+                      &accel);
         if (ai->ticks_until_next_action == 0)
         {
             ai->ticks_until_next_action = 25;
@@ -491,7 +503,8 @@ void tick_ai_ankylosaurus(EntityIdx entity, struct rr_simulation *simulation)
         rr_component_physical_set_angle(physical, target_angle);
 
         rr_vector_from_polar(&accel, RR_PLAYER_SPEED * 1.1, physical->angle);
-        rr_vector_add(&physical->acceleration, &accel);
+        rr_vector_add(rr_simulation_get_acceleration(simulation, entity),
+                      &accel);
         ai->ticks_until_next_action = 10;
         if (rr_vector_magnitude_cmp(&delta, 100 + physical->radius) == -1)
         {
@@ -519,7 +532,8 @@ void tick_ai_ankylosaurus(EntityIdx entity, struct rr_simulation *simulation)
         rr_component_physical_set_angle(physical, target_angle);
 
         rr_vector_from_polar(&accel, RR_PLAYER_SPEED * 1.8, physical->angle);
-        rr_vector_add(&physical->acceleration, &accel);
+        rr_vector_add(rr_simulation_get_acceleration(simulation, entity),
+                      &accel);
         if (ai->ticks_until_next_action == 0)
         {
             ai->ticks_until_next_action = 10;
@@ -542,7 +556,8 @@ void tick_ai_ankylosaurus(EntityIdx entity, struct rr_simulation *simulation)
         rr_component_physical_set_angle(physical, target_angle + M_PI);
 
         rr_vector_from_polar(&accel, RR_PLAYER_SPEED * 3.0, physical->angle);
-        rr_vector_add(&physical->acceleration, &accel);
+        rr_vector_add(rr_simulation_get_acceleration(simulation, entity),
+                      &accel);
         if (ai->ticks_until_next_action == 0)
         {
             ai->ticks_until_next_action = 10;
@@ -578,8 +593,8 @@ void tick_ai_meteor(EntityIdx entity, struct rr_simulation *simulation)
                 (2 * angle - (M_PI + physical->bearing_angle));
         }
 
-        rr_vector_from_polar(&physical->acceleration, RR_PLAYER_SPEED * 0.15,
-                             physical->bearing_angle);
+        rr_vector_from_polar(rr_simulation_get_acceleration(simulation, entity),
+                             RR_PLAYER_SPEED * 0.15, physical->bearing_angle);
         rr_component_physical_set_angle(physical, physical->angle + 0.1);
         break;
     default:
@@ -620,7 +635,8 @@ void tick_ai_quetzalcoaltus(EntityIdx entity, struct rr_simulation *simulation)
             ai->ticks_until_next_action = 20;
 
             rr_vector_from_polar(&delta, RR_PLAYER_SPEED * 18, physical->angle);
-            rr_vector_add(&physical->acceleration, &delta);
+            rr_vector_add(rr_simulation_get_acceleration(simulation, entity),
+                          &delta);
         }
         break;
     }
@@ -0,0 +1,453 @@
+// Copyright (C) 2024 Paul Johnson
+// Copyright (C) 2024-2025 Maxim Nesterov
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <Server/Network.h>
+
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <libwebsockets.h>
+
+#include <Server/Server.h>
+#include <Shared/Api.h>
+
+#define connection_slot(connection) ((connection) & 0xffff)
+#define connection_generation(connection) ((connection) >> 16)
+
+static uint8_t network_queue_push(struct rr_network_queue *this,
+                                  struct rr_network_event *event)
+{
+    uint32_t tail = this->tail;
+    if (tail - __atomic_load_n(&this->head, __ATOMIC_ACQUIRE) ==
+        RR_NETWORK_QUEUE_SIZE)
+        return 0;
+    this->events[tail & (RR_NETWORK_QUEUE_SIZE - 1)] = *event;
+    __atomic_store_n(&this->tail, tail + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+static uint8_t network_queue_pop(struct rr_network_queue *this,
+                                 struct rr_network_event *event)
+{
+    uint32_t head = this->head;
+    if (head == __atomic_load_n(&this->tail, __ATOMIC_ACQUIRE))
+        return 0;
+    *event = this->events[head & (RR_NETWORK_QUEUE_SIZE - 1)];
+    __atomic_store_n(&this->head, head + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+// The network thread waits for the simulation thread instead of dropping
+// events, losing a connect or disconnect would desync the client table
+static void network_push_inbound(struct rr_network *this, uint8_t type,
+                                 uint32_t connection, uint8_t *data,
+                                 uint64_t size)
+{
+    struct rr_network_event event = {data, size, connection, type};
+    while (!network_queue_push(&this->inbound, &event))
+        sched_yield();
+}
+
+static uint8_t network_push_outbound(struct rr_network *this, uint8_t type,
+                                     uint32_t connection, uint8_t *data,
+                                     uint64_t size)
+{
+    struct rr_network_event event = {NULL, size, connection, type};
+    if (type == rr_network_event_kick)
+        event.data = data;
+    else
+    {
+        event.data = malloc(LWS_PRE + size);
+        memcpy(event.data + LWS_PRE, data, size);
+    }
+    if (network_queue_push(&this->outbound, &event))
+        return 1;
+    if (type != rr_network_event_kick)
+        free(event.data);
+    return 0;
+}
+
+static uint64_t network_frame_size(uint64_t size)
+{
+    return (sizeof(uint64_t) + LWS_PRE + size + 7) & ~(uint64_t)7;
+}
+
+// Network thread only. Returns the frame at, and moves past it
+static uint8_t *network_ring_next(struct rr_network_ring *this, uint64_t *at)
+{
+    uint64_t size;
+    memcpy(&size, this->data + (*at & (RR_NETWORK_RING_SIZE - 1)), sizeof size);
+    if (size == UINT64_MAX)
+    {
+        *at = (*at | (RR_NETWORK_RING_SIZE - 1)) + 1;
+        memcpy(&size, this->data, sizeof size);
+    }
+    uint8_t *frame = this->data + (*at & (RR_NETWORK_RING_SIZE - 1));
+    *at += network_frame_size(size);
+    return frame;
+}
+
+// Network thread only. Drops every frame that wasn't written yet
+static void network_ring_release(struct rr_network_ring *this)
+{
+    __atomic_store_n(&this->head, this->queued, __ATOMIC_RELEASE);
+}
+
+static struct rr_network_connection *
+network_get_connection(struct rr_network *this, uint32_t connection)
+{
+    if (connection_slot(connection) >= RR_MAX_CONNECTION_COUNT)
+        return NULL;
+    struct rr_network_connection *c =
+        &this->connections[connection_slot(connection)];
+    if (c->socket == NULL || c->generation != connection_generation(connection))
+        return NULL;
+    return c;
+}
+
+static void network_drain_outbound(struct rr_network *this)
+{
+    struct rr_network_event event;
+    while (network_queue_pop(&this->outbound, &event))
+    {
+        if (event.type == rr_network_event_api_write)
+        {
+            lws_write(this->api_client, event.data + LWS_PRE, event.size,
+                      LWS_WRITE_BINARY);
+            free(event.data);
+            continue;
+        }
+        struct rr_network_connection *connection =
+            network_get_connection(this, event.connection);
+        struct rr_network_ring *ring = NULL;
+        if (event.type == rr_network_event_write)
+        {
+            ring = &this->rings[connection_slot(event.connection)];
+            network_ring_next(ring, &ring->queued);
+        }
+        if (connection == NULL || connection->kick_reason != NULL)
+        {
+            // stale frame for a socket that closed in the meantime. the
+            // simulation thread stops writing to a connection before the
+            // slot's next one starts so nothing live is queued before it
+            if (ring != NULL)
+                network_ring_release(ring);
+            continue;
+        }
+        if (event.type == rr_network_event_kick)
+            connection->kick_reason = (char const *)event.data;
+        lws_callback_on_writable(connection->socket);
+    }
+}
+
+static int lws_callback(struct lws *ws, enum lws_callback_reasons reason,
+                        void *user, void *packet, size_t size)
+{
+    struct rr_network *this =
+        &((struct rr_server *)lws_context_user(lws_get_context(ws)))->network;
+    uint32_t *handle = user;
+    switch (reason)
+    {
+    case LWS_CALLBACK_ESTABLISHED:
+    {
+        *handle = RR_NULL_CONNECTION;
+        char xff[100];
+        if (lws_hdr_copy(ws, xff, 100, WSI_TOKEN_X_FORWARDED_FOR) <= 0)
+        {
+            lws_close_reason(ws, LWS_CLOSE_STATUS_GOINGAWAY,
+                             (uint8_t *)"could not get xff header",
+                             sizeof "could not get xff header" - 1);
+            return -1;
+        }
+        for (uint32_t i = 0; i < RR_MAX_CONNECTION_COUNT; ++i)
+        {
+            struct rr_network_connection *connection = &this->connections[i];
+            if (connection->socket != NULL)
+                continue;
+            connection->socket = ws;
+            connection->kick_reason = NULL;
+            // seen by the simulation thread through the connect event
+            if (this->rings[i].data == NULL)
+                this->rings[i].data = malloc(RR_NETWORK_RING_SIZE);
+            if (++connection->generation == 0)
+                connection->generation = 1;
+            *handle = (uint32_t)connection->generation << 16 | i;
+            network_push_inbound(this, rr_network_event_connect, *handle,
+                                 (uint8_t *)strdup(xff), strlen(xff));
+            return 0;
+        }
+        lws_close_reason(ws, LWS_CLOSE_STATUS_GOINGAWAY,
+                         (uint8_t *)"too many active clients",
+                         sizeof "too many active clients" - 1);
+        return -1;
+    }
+    case LWS_CALLBACK_CLOSED:
+    {
+        struct rr_network_connection *connection =
+            network_get_connection(this, *handle);
+        if (connection == NULL)
+            return 0;
+        network_ring_release(&this->rings[connection_slot(*handle)]);
+        connection->socket = NULL;
+        network_push_inbound(this, rr_network_event_disconnect, *handle, NULL,
+                             connection->kick_reason != NULL);
+        return 0;
+    }
+    case LWS_CALLBACK_SERVER_WRITEABLE:
+    {
+        struct rr_network_connection *connection =
+            network_get_connection(this, *handle);
+        if (connection == NULL)
+            return -1;
+        struct rr_network_ring *ring = &this->rings[connection_slot(*handle)];
+        if (connection->kick_reason != NULL)
+        {
+            network_ring_release(ring);
+            lws_close_reason(ws, LWS_CLOSE_STATUS_GOINGAWAY,
+                             (uint8_t *)connection->kick_reason,
+                             strlen(connection->kick_reason));
+            return -1;
+        }
+        for (uint64_t at = ring->head; at != ring->queued;)
+        {
+            uint8_t *frame = network_ring_next(ring, &at);
+            uint64_t size;
+            memcpy(&size, frame, sizeof size);
+            lws_write(ws, frame + sizeof size + LWS_PRE, size,
+                      LWS_WRITE_BINARY);
+        }
+        network_ring_release(ring);
+        return 0;
+    }
+    case LWS_CALLBACK_RECEIVE:
+    {
+        if (network_get_connection(this, *handle) == NULL)
+            return -1;
+        uint8_t *copy = malloc(size);
+        memcpy(copy, packet, size);
+        network_push_inbound(this, rr_network_event_receive, *handle, copy,
+                             size);
+        return 0;
+    }
+    default:
+        return 0;
+    }
+}
+
+static int api_lws_callback(struct lws *ws, enum lws_callback_reasons reason,
+                            void *user, void *packet, size_t size)
+{
+    struct rr_network *this =
+        &((struct rr_server *)lws_context_user(lws_get_context(ws)))->network;
+    switch (reason)
+    {
+    case LWS_CALLBACK_CLIENT_ESTABLISHED:
+        network_push_inbound(this, rr_network_event_api_connect,
+                             RR_NULL_CONNECTION, NULL, 0);
+        break;
+    case LWS_CALLBACK_CLIENT_RECEIVE:
+    {
+        uint8_t *copy = malloc(size);
+        memcpy(copy, packet, size);
+        network_push_inbound(this, rr_network_event_api_receive,
+                             RR_NULL_CONNECTION, copy, size);
+        break;
+    }
+    case LWS_CALLBACK_CLIENT_CLOSED:
+        // uh oh
+        fprintf(stderr, "api ws disconnected\n");
+        abort();
+        break;
+    case LWS_CALLBACK_CLIENT_CONNECTION_ERROR:
+        fprintf(stderr, "api ws refused to connect\n");
+        abort();
+        break;
+    default:
+        return 0;
+    }
+    return 0;
+}
+
+static void *network_thread(void *_this)
+{
+    struct rr_network *this = _this;
+    while (1)
+    {
+        network_drain_outbound(this);
+        // the api context is only polled so this thread has one place to
+        // wait, woken up by rr_network_flush at least once per tick. api
+        // writes drained above go out before it does
+        lws_service(this->api_client_context, -1);
+        lws_service(this->server, 0);
+    }
+    return NULL;
+}
+
+void rr_network_start(struct rr_server *server)
+{
+    struct rr_network *this = &server->network;
+    {
+        struct lws_context_creation_info info = {0};
+        // lws keeps pointing at these after this function returns
+        static struct lws_protocols protocols[] = {
+            {"g", lws_callback, sizeof(uint32_t), MESSAGE_BUFFER_SIZE, 0, NULL,
+             0},
+            {0}};
+
+        info.protocols = protocols;
+
+        info.port = 1234;
+        info.user = server;
+        info.pt_serv_buf_size = MESSAGE_BUFFER_SIZE;
+
+        this->server = lws_create_context(&info);
+        if (!this->server)
+        {
+            puts("couldn't create server context");
+            exit(1);
+        }
+    }
+    {
+        struct lws_context_creation_info info = {0};
+        struct lws_client_connect_info client_info = {0};
+
+        static struct lws_protocols protocols[] = {
+            {
+                "g",
+                api_lws_callback,
+                0,
+                128 * 1024,
+            },
+            {NULL, NULL, 0, 0} // terminator
+        };
+        info.port = CONTEXT_PORT_NO_LISTEN;
+        info.protocols = protocols;
+        info.gid = -1;
+        info.uid = -1;
+        info.user = server;
+
+        this->api_client_context = lws_create_context(&info);
+        if (!this->api_client_context)
+        {
+            puts("couldn't create api server context");
+            exit(1);
+        }
+        client_info.context = this->api_client_context;
+        client_info.address =
+#ifndef RIVET_BUILD
+            "localhost";
+#else
+            "45.79.197.197";
+#endif
+        client_info.port = 55554;
+        client_info.path = "/api/" RR_API_SECRET;
+        client_info.host = client_info.address;
+        client_info.origin = client_info.address;
+        client_info.protocol = protocols[0].name;
+        this->api_client = lws_client_connect_via_info(&client_info);
+        if (!this->api_client)
+        {
+            puts("couldn't create api client");
+            exit(1);
+        }
+    }
+    if (pthread_create(&this->thread, NULL, network_thread, this))
+    {
+        puts("couldn't create network thread");
+        exit(1);
+    }
+}
+
+void rr_network_free(struct rr_network *this)
+{
+    lws_context_destroy(this->server);
+}
+
+uint8_t rr_network_poll(struct rr_network *this, struct rr_network_event *event)
+{
+    return network_queue_pop(&this->inbound, event);
+}
+
+uint8_t rr_network_write(struct rr_network *this, uint32_t connection,
+                         uint8_t *data, uint64_t size)
+{
+    if (connection_slot(connection) >= RR_MAX_CONNECTION_COUNT)
+        return 0;
+    struct rr_network_ring *ring = &this->rings[connection_slot(connection)];
+    if (ring->data == NULL)
+        return 0;
+    uint64_t frame_size = network_frame_size(size);
+    uint64_t tail = ring->tail;
+    uint64_t at = tail & (RR_NETWORK_RING_SIZE - 1);
+    uint64_t skip = at + frame_size > RR_NETWORK_RING_SIZE
+                        ? RR_NETWORK_RING_SIZE - at
+                        : 0;
+    if (tail + skip + frame_size -
+            __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) >
+        RR_NETWORK_RING_SIZE)
+        return 0;
+    if (skip)
+    {
+        uint64_t wrap = UINT64_MAX;
+        memcpy(ring->data + at, &wrap, sizeof wrap);
+        at = 0;
+    }
+    uint8_t *frame = ring->data + at;
+    memcpy(frame, &size, sizeof size);
+    memcpy(frame + sizeof size + LWS_PRE, data, size);
+    struct rr_network_event event = {frame, size, connection,
+                                     rr_network_event_write};
+    if (!network_queue_push(&this->outbound, &event))
+        return 0;
+    ring->tail = tail + skip + frame_size;
+    return 1;
+}
+
+uint64_t rr_network_write_position(struct rr_network *this, uint32_t connection)
+{
+    if (connection_slot(connection) >= RR_MAX_CONNECTION_COUNT)
+        return 0;
+    return this->rings[connection_slot(connection)].tail;
+}
+
+uint64_t rr_network_sent_position(struct rr_network *this, uint32_t connection)
+{
+    if (connection_slot(connection) >= RR_MAX_CONNECTION_COUNT)
+        return 0;
+    return __atomic_load_n(&this->rings[connection_slot(connection)].head,
+                           __ATOMIC_ACQUIRE);
+}
+
+uint8_t rr_network_kick(struct rr_network *this, uint32_t connection,
+                        char const *reason)
+{
+    return network_push_outbound(this, rr_network_event_kick, connection,
+                                 (uint8_t *)reason, 0);
+}
+
+uint8_t rr_network_write_api(struct rr_network *this, uint8_t *data,
+                             uint64_t size)
+{
+    return network_push_outbound(this, rr_network_event_api_write,
+                                 RR_NULL_CONNECTION, data, size);
+}
+
+void rr_network_flush(struct rr_network *this)
+{
+    lws_cancel_service(this->server);
+}
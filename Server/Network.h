@@ -0,0 +1,118 @@
+// Copyright (C) 2024 Paul Johnson
+// Copyright (C) 2024-2025 Maxim Nesterov
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <pthread.h>
+#include <stdint.h>
+
+#define RR_NETWORK_QUEUE_SIZE (8192)
+// Room for two of the largest frames, so one always fits even when it has
+// to wrap around. A power of two like MESSAGE_BUFFER_SIZE
+#define RR_NETWORK_RING_SIZE (4 * MESSAGE_BUFFER_SIZE)
+#define RR_MAX_CONNECTION_COUNT (256)
+#define RR_NULL_CONNECTION (0)
+
+struct lws;
+struct lws_context;
+struct rr_server;
+
+enum rr_network_event_type
+{
+    // network thread to simulation thread
+    rr_network_event_connect,    // data is the x-forwarded-for header
+    rr_network_event_disconnect, // size is 1 if the network thread kicked
+    rr_network_event_receive,
+    rr_network_event_api_connect,
+    rr_network_event_api_receive,
+    // simulation thread to network thread
+    rr_network_event_write,     // data is the frame in the connection's ring
+    rr_network_event_kick,      // data is a static close reason
+    rr_network_event_api_write, // data has LWS_PRE bytes of headroom
+};
+
+// Buffers belong to whoever pops the event, except for kick reasons
+struct rr_network_event
+{
+    uint8_t *data;
+    uint64_t size;
+    uint32_t connection;
+    uint8_t type;
+};
+
+// Single producer single consumer ring
+struct rr_network_queue
+{
+    struct rr_network_event events[RR_NETWORK_QUEUE_SIZE];
+    uint32_t head;
+    uint32_t tail;
+};
+
+// Bytes the simulation thread writes outgoing frames into, one per connection
+// slot. A frame is its size as a uint64, LWS_PRE bytes of headroom and the
+// payload, padded to 8 bytes. A size of UINT64_MAX means the next frame
+// starts back at the beginning. Space is handed back in bulk once a
+// connection's frames are written or dropped
+struct rr_network_ring
+{
+    uint8_t *data;
+    // simulation thread, end of the frames written so far
+    uint64_t tail;
+    // network thread, end of the frames whose events were popped
+    uint64_t queued;
+    // network thread, everything before this may be overwritten
+    uint64_t head;
+};
+
+// Only ever touched by the network thread
+struct rr_network_connection
+{
+    struct lws *socket;
+    char const *kick_reason;
+    uint16_t generation;
+};
+
+struct rr_network
+{
+    struct rr_network_queue inbound;
+    struct rr_network_queue outbound;
+    struct rr_network_connection connections[RR_MAX_CONNECTION_COUNT];
+    struct rr_network_ring rings[RR_MAX_CONNECTION_COUNT];
+    struct lws_context *server;
+    struct lws_context *api_client_context;
+    struct lws *api_client;
+    pthread_t thread;
+};
+
+// Creates both lws contexts and hands them to a new network thread. Every
+// event after this point arrives through rr_network_poll
+void rr_network_start(struct rr_server *);
+void rr_network_free(struct rr_network *);
+
+// Simulation thread only. Returns 0 once the inbound queue is empty
+uint8_t rr_network_poll(struct rr_network *, struct rr_network_event *);
+// Simulation thread only. Returns 0 if the outbound queue or the connection's
+// ring is full, the frame is dropped in that case
+uint8_t rr_network_write(struct rr_network *, uint32_t, uint8_t *, uint64_t);
+// Simulation thread only. Where in the connection's ring the next frame goes,
+// and how far the network thread got sending. Every frame before a write
+// position is out once the sent position reaches it
+uint64_t rr_network_write_position(struct rr_network *, uint32_t);
+uint64_t rr_network_sent_position(struct rr_network *, uint32_t);
+uint8_t rr_network_kick(struct rr_network *, uint32_t, char const *);
+uint8_t rr_network_write_api(struct rr_network *, uint8_t *, uint64_t);
+// Wakes the network thread so it picks up everything written so far
+void rr_network_flush(struct rr_network *);
@@ -20,7 +20,6 @@
 #include <math.h>
 #include <pthread.h>
 #include <string.h>
-#include <sys/time.h>
 #include <unistd.h>
 
 #include <libwebsockets.h>
@@ -128,16 +127,6 @@ void rr_server_client_free(struct rr_server_client *this)
     uint8_t i = this - this->server->clients;
     for (uint8_t j = 0; j < RR_MAX_CLIENT_COUNT; ++j)
         rr_bitset_unset(this->server->clients[j].blocked_clients, i);
-    struct rr_server_client_message *message = this->message_root;
-    while (message != NULL)
-    {
-        struct rr_server_client_message *tmp = message->next;
-        free(message->packet);
-        free(message);
-        message = tmp;
-    }
-    this->message_at = this->message_root = NULL;
-    this->message_length = 0;
     puts("<rr_server::client_disconnect>");
 }
 
@@ -209,75 +198,69 @@ static void write_animation_function(struct rr_simulation *simulation,
     }
 }
 
-void rr_server_client_broadcast_update(struct rr_server_client *this)
+static void write_update_message(struct rr_server_client *this,
+                                 struct proto_bug *encoder)
 {
     struct rr_server *server = this->server;
-    struct rr_simulation *simulation = &server->simulation;
-    struct proto_bug encoder;
-    proto_bug_init(&encoder, outgoing_message);
-    proto_bug_write_uint8(&encoder, rr_clientbound_update, "header");
+    proto_bug_write_uint8(encoder, rr_clientbound_update, "header");
 
     struct rr_squad *squad = rr_client_get_squad(server, this);
     int8_t kick_vote_pos =
         rr_squad_get_client_slot(server, this)->kick_vote_pos;
     if (kick_vote_pos == -1 && this->ticks_to_next_kick_vote > 0)
         kick_vote_pos = -2;
-    proto_bug_write_uint8(&encoder, kick_vote_pos, "kick vote");
+    proto_bug_write_uint8(encoder, kick_vote_pos, "kick vote");
     for (uint32_t i = 0; i < RR_SQUAD_MEMBER_COUNT; ++i)
     {
         if (squad->members[i].in_use == 0)
         {
-            proto_bug_write_uint8(&encoder, 0, "bitbit");
+            proto_bug_write_uint8(encoder, 0, "bitbit");
             continue;
         }
         struct rr_squad_member *member = &squad->members[i];
-        proto_bug_write_uint8(&encoder, 1, "bitbit");
-        proto_bug_write_uint8(&encoder, member->playing, "ready");
-        proto_bug_write_uint8(&encoder, member->client->disconnected,
+        proto_bug_write_uint8(encoder, 1, "bitbit");
+        proto_bug_write_uint8(encoder, member->playing, "ready");
+        proto_bug_write_uint8(encoder, member->client->disconnected,
                               "disconnected");
         uint8_t j = member->client - server->clients;
         uint8_t blocked = rr_bitset_get(this->blocked_clients, j);
-        proto_bug_write_uint8(&encoder, blocked, "blocked");
-        proto_bug_write_uint8(&encoder, member->is_dev, "is_dev");
-        proto_bug_write_uint8(&encoder, member->kick_vote_count, "kick votes");
-        proto_bug_write_varuint(&encoder, member->level, "level");
-        proto_bug_write_string(&encoder, member->nickname, 16, "nickname");
+        proto_bug_write_uint8(encoder, blocked, "blocked");
+        proto_bug_write_uint8(encoder, member->is_dev, "is_dev");
+        proto_bug_write_uint8(encoder, member->kick_vote_count, "kick votes");
+        proto_bug_write_varuint(encoder, member->level, "level");
+        proto_bug_write_string(encoder, member->nickname, 16, "nickname");
         for (uint8_t j = 0; j < RR_MAX_SLOT_COUNT * 2; ++j)
         {
-            proto_bug_write_uint8(&encoder, member->loadout[j].id, "id");
-            proto_bug_write_uint8(&encoder, member->loadout[j].rarity, "rar");
+            proto_bug_write_uint8(encoder, member->loadout[j].id, "id");
+            proto_bug_write_uint8(encoder, member->loadout[j].rarity, "rar");
         }
     }
-    proto_bug_write_uint8(&encoder, this->squad, "sqidx");
-    proto_bug_write_uint8(&encoder, squad->owner, "sqown");
-    proto_bug_write_uint8(&encoder, this->squad_pos, "sqpos");
-    proto_bug_write_uint8(&encoder, squad->private, "private");
-    proto_bug_write_uint8(&encoder, squad->expose_code, "expose_code");
-    proto_bug_write_uint8(&encoder, RR_GLOBAL_BIOME, "biome");
+    proto_bug_write_uint8(encoder, this->squad, "sqidx");
+    proto_bug_write_uint8(encoder, squad->owner, "sqown");
+    proto_bug_write_uint8(encoder, this->squad_pos, "sqpos");
+    proto_bug_write_uint8(encoder, squad->private, "private");
+    proto_bug_write_uint8(encoder, squad->expose_code, "expose_code");
+    proto_bug_write_uint8(encoder, RR_GLOBAL_BIOME, "biome");
     char joined_code[16];
     sprintf(joined_code, "%s-%s", server->server_alias, squad->squad_code);
-    proto_bug_write_string(&encoder, joined_code, 16, "squad code");
-    proto_bug_write_uint8(&encoder, this->afk_ticks > 9 * 60 * 25, "afk");
-    proto_bug_write_uint8(&encoder, this->player_info != NULL, "in game");
+    proto_bug_write_string(encoder, joined_code, 16, "squad code");
+    proto_bug_write_uint8(encoder,
+                          this->afk_ticks > 9 * 60 * RR_SERVER_TICK_RATE,
+                          "afk");
+    proto_bug_write_uint8(encoder, this->player_info != NULL, "in game");
     if (this->player_info != NULL)
-        rr_simulation_write_binary(&server->simulation, &encoder,
-                                   this->player_info);
-    rr_server_client_write_message(this, encoder.start,
-                                   encoder.current - encoder.start);
+        rr_simulation_write_binary(&server->simulation, encoder,
+                                   this->player_info, &server->update_cache);
 }
 
-void rr_server_client_broadcast_animation_update(struct rr_server_client *this)
+static void write_animation_update_message(struct rr_server_client *this,
+                                           struct proto_bug *encoder)
 {
-    struct rr_server *server = this->server;
-    struct rr_simulation *simulation = &server->simulation;
-    struct proto_bug encoder;
-    proto_bug_init(&encoder, outgoing_message);
-    proto_bug_write_uint8(&encoder, rr_clientbound_animation_update, "header");
+    struct rr_simulation *simulation = &this->server->simulation;
+    proto_bug_write_uint8(encoder, rr_clientbound_animation_update, "header");
     for (uint32_t i = 0; i < simulation->animation_length; ++i)
-        write_animation_function(simulation, &encoder, this, i);
-    proto_bug_write_uint8(&encoder, 0, "continue");
-    rr_server_client_write_message(this, encoder.start,
-                                   encoder.current - encoder.start);
+        write_animation_function(simulation, encoder, this, i);
+    proto_bug_write_uint8(encoder, 0, "continue");
 }
 
 static void delete_entity_function(EntityIdx entity, void *_captures)
@@ -303,17 +286,23 @@ void rr_server_init(struct rr_server *this)
     this->simulation.server = this;
     for (uint32_t i = 0; i < RR_SQUAD_COUNT; ++i)
         rr_squad_init(&this->squads[i], this, i);
+    // the main thread encodes alongside the pool
+    long cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+    rr_worker_pool_init(&this->worker_pool, cpu_count > 1 ? cpu_count - 1 : 0);
 }
 
 void rr_server_free(struct rr_server *this)
 {
-    lws_context_destroy(this->server);
+    rr_network_free(&this->network);
 }
 
 static void rr_simulation_tick_entity_resetter_function(EntityIdx entity,
                                                         void *captures)
 {
     struct rr_simulation *this = captures;
+    if (rr_simulation_has_physical(this, entity))
+        rr_component_physical_update_sent(
+            rr_simulation_get_physical(this, entity));
 #define XX(COMPONENT, ID)                                                      \
     if (rr_simulation_has_##COMPONENT(this, entity))                           \
         rr_simulation_get_##COMPONENT(this, entity)->protocol_state = 0;
@@ -348,29 +337,30 @@ static void rr_simulation_dev_cheat_set_max_health(EntityIdx entity, void *_capt
         rr_component_health_set_health(health, health->max_health);
 }
 
-static int handle_lws_event(struct rr_server *this, struct lws *ws,
-                            enum lws_callback_reasons reason, uint8_t *packet,
-                            size_t size)
+static struct rr_server_client *find_client(struct rr_server *this,
+                                            uint32_t connection)
 {
-    switch (reason)
+    for (uint64_t i = 0; i < RR_MAX_CLIENT_COUNT; ++i)
+        if (rr_bitset_get(this->clients_in_use, i) &&
+            this->clients[i].connection == connection)
+            return this->clients + i;
+    return NULL;
+}
+
+static void handle_network_event(struct rr_server *this, uint8_t type,
+                                 uint32_t connection, uint8_t *packet,
+                                 uint64_t size)
+{
+    switch (type)
     {
-    case LWS_CALLBACK_ESTABLISHED:
+    case rr_network_event_connect:
     {
         if (!this->api_ws_ready)
         {
-            lws_close_reason(ws, LWS_CLOSE_STATUS_GOINGAWAY,
-                             (uint8_t *)"api ws not ready",
-                             sizeof "api ws not ready" - 1);
-            return -1;
-        }
-        char xff[100];
-        if (lws_hdr_copy(ws, xff, 100, WSI_TOKEN_X_FORWARDED_FOR) <= 0)
-        {
-            lws_close_reason(ws, LWS_CLOSE_STATUS_GOINGAWAY,
-                             (uint8_t *)"could not get xff header",
-                             sizeof "could not get xff header" - 1);
-            return -1;
+            rr_network_kick(&this->network, connection, "api ws not ready");
+            return;
         }
+        char *xff = (char *)packet;
         puts(xff);
         for (uint64_t i = 0; i < RR_MAX_CLIENT_COUNT; i++)
             if (!rr_bitset_get_bit(this->clients_in_use, i))
@@ -378,10 +368,9 @@ static int handle_lws_event(struct rr_server *this, struct lws *ws,
                 rr_bitset_set(this->clients_in_use, i);
                 rr_server_client_init(this->clients + i);
                 this->clients[i].server = this;
-                this->clients[i].socket_handle = ws;
+                this->clients[i].connection = connection;
                 this->clients[i].in_use = 1;
                 strcpy(this->clients[i].ip_address, xff);
-                lws_set_opaque_user_data(ws, this->clients + i);
                 // send encryption key
                 struct proto_bug encryption_key_encoder;
                 proto_bug_init(&encryption_key_encoder, outgoing_message);
@@ -405,22 +394,23 @@ static int handle_lws_event(struct rr_server *this, struct lws *ws,
                 rr_encrypt(outgoing_message, 1024, 59013169977270713ull);
                 rr_server_client_write_message(this->clients + i,
                                                outgoing_message, 1024);
-                return 0;
+                return;
             }
 
-        lws_close_reason(ws, LWS_CLOSE_STATUS_GOINGAWAY,
-                         (uint8_t *)"too many active clients",
-                         sizeof "to many active clients" - 1);
-        return -1;
+        rr_network_kick(&this->network, connection, "too many active clients");
+        return;
     }
-    case LWS_CALLBACK_CLOSED:
+    case rr_network_event_disconnect:
     {
-        struct rr_server_client *client = lws_get_opaque_user_data(ws);
+        struct rr_server_client *client = find_client(this, connection);
         if (client != NULL)
         {
             uint64_t i = (client - this->clients);
+            // the network thread kicked it for falling behind on writes
+            if (size)
+                client->pending_kick = 1;
             client->disconnected = 1;
-            client->socket_handle = NULL;
+            client->connection = RR_NULL_CONNECTION;
             client->player_accel_x = 0;
             client->player_accel_y = 0;
             if (client->player_info != NULL)
@@ -432,7 +422,7 @@ static int handle_lws_event(struct rr_server *this, struct lws *ws,
                 rr_server_client_free(client);
             }
             if (client->received_first_packet == 0)
-                return 0;
+                return;
 #ifdef RIVET_BUILD
             char *token = malloc(500);
             strncpy(token, client->rivet_account.token, 500);
@@ -446,54 +436,18 @@ static int handle_lws_event(struct rr_server *this, struct lws *ws,
             rr_binary_encoder_write_nt_string(
                 &encoder, this->clients[i].rivet_account.uuid);
             rr_binary_encoder_write_uint8(&encoder, i);
-            lws_write(this->api_client, encoder.start,
-                      encoder.at - encoder.start, LWS_WRITE_BINARY);
-            return 0;
+            rr_network_write_api(&this->network, encoder.start,
+                                 encoder.at - encoder.start);
+            return;
         }
         puts("client joined but instakicked");
         break;
     }
-    case LWS_CALLBACK_SERVER_WRITEABLE:
-    {
-        struct rr_server_client *client = lws_get_opaque_user_data(ws);
-        if (client == NULL)
-            return -1;
-        if (client->pending_kick)
-        {
-            struct rr_server_client_message *message = client->message_root;
-            while (message != NULL)
-            {
-                struct rr_server_client_message *tmp = message->next;
-                free(message->packet);
-                free(message);
-                message = tmp;
-            }
-            client->message_at = client->message_root = NULL;
-            client->message_length = 0;
-            lws_close_reason(ws, LWS_CLOSE_STATUS_GOINGAWAY,
-                             (uint8_t *)"kicked for unspecified reason",
-                             sizeof "kicked for unspecified reason" - 1);
-            return -1;
-        }
-        struct rr_server_client_message *message = client->message_root;
-        while (message != NULL)
-        {
-            lws_write(ws, message->packet + LWS_PRE, message->len,
-                      LWS_WRITE_BINARY);
-            struct rr_server_client_message *tmp = message->next;
-            free(message->packet);
-            free(message);
-            message = tmp;
-        }
-        client->message_at = client->message_root = NULL;
-        client->message_length = 0;
-        break;
-    }
-    case LWS_CALLBACK_RECEIVE:
+    case rr_network_event_receive:
     {
-        struct rr_server_client *client = lws_get_opaque_user_data(ws);
+        struct rr_server_client *client = find_client(this, connection);
         if (client == NULL)
-            return -1;
+            return;
         uint64_t i = (client - this->clients);
         rr_decrypt(packet, size, client->serverbound_encryption_key);
         client->serverbound_encryption_key =
@@ -513,11 +467,9 @@ static int handle_lws_event(struct rr_server *this, struct lws *ws,
                 printf("%lu %lu\n", client->requested_verification,
                        received_verification);
                 fputs("invalid verification\n", stderr);
-                lws_close_reason(ws, LWS_CLOSE_STATUS_GOINGAWAY,
-                                 (uint8_t *)"invalid v",
-                                 sizeof "invalid v" - 1);
+                rr_network_kick(&this->network, connection, "invalid v");
                 client->pending_kick = 1;
-                return -1;
+                return;
             }
 
             memset(&client->rivet_account, 0, sizeof(struct rr_rivet_account));
@@ -639,9 +591,9 @@ static int handle_lws_event(struct rr_server *this, struct lws *ws,
             rr_binary_encoder_write_nt_string(&encoder,
                                               client->rivet_account.uuid);
             rr_binary_encoder_write_uint8(&encoder, i);
-            lws_write(this->api_client, encoder.start,
-                      encoder.at - encoder.start, LWS_WRITE_BINARY);
-            return 0;
+            rr_network_write_api(&this->network, encoder.start,
+                                 encoder.at - encoder.start);
+            return;
         }
         if (!client->verified)
             break;
@@ -651,11 +603,9 @@ static int handle_lws_event(struct rr_server *this, struct lws *ws,
         {
             printf("%u %u\n", client->quick_verification, qv);
             fputs("invalid quick verification\n", stderr);
-            lws_close_reason(ws, LWS_CLOSE_STATUS_GOINGAWAY,
-                             (uint8_t *)"invalid qv",
-                             sizeof "invalid qv" - 1);
+            rr_network_kick(&this->network, connection, "invalid qv");
             client->pending_kick = 1;
-            return -1;
+            return;
         }
         uint8_t header = proto_bug_read_uint8(&encoder, "header");
         switch (header)
@@ -1043,7 +993,7 @@ static int handle_lws_event(struct rr_server *this, struct lws *ws,
                 {
                     if (client->ticks_to_next_kick_vote > 0)
                         break;
-                    client->ticks_to_next_kick_vote = 60 * 25;
+                    client->ticks_to_next_kick_vote = 60 * RR_SERVER_TICK_RATE;
                     rr_squad_get_client_slot(this, client)->kick_vote_pos = pos;
                     if (++kick_member->kick_vote_count <
                         RR_SQUAD_MEMBER_COUNT - 1)
@@ -1285,23 +1235,19 @@ static int handle_lws_event(struct rr_server *this, struct lws *ws,
         default:
             break;
         }
-        return 0;
+        return;
     }
     default:
-        return 0;
+        return;
     }
-
-    return 0;
 }
 
-static int api_lws_callback(struct lws *ws, enum lws_callback_reasons reason,
-                            void *user, void *packet, size_t size)
+static void handle_api_event(struct rr_server *this, uint8_t type,
+                             uint8_t *packet)
 {
-    struct rr_server *this =
-        (struct rr_server *)lws_context_user(lws_get_context(ws));
-    switch (reason)
+    switch (type)
     {
-    case LWS_CALLBACK_CLIENT_ESTABLISHED:
+    case rr_network_event_api_connect:
     {
         puts("connected to api server");
         this->api_ws_ready = 1;
@@ -1315,11 +1261,11 @@ static int api_lws_callback(struct lws *ws, enum lws_callback_reasons reason,
         rr_binary_encoder_init(&encoder, outgoing_message);
         rr_binary_encoder_write_uint8(&encoder, 101);
         rr_binary_encoder_write_nt_string(&encoder, lobby_id);
-        lws_write(this->api_client, encoder.start, encoder.at - encoder.start,
-                  LWS_WRITE_BINARY);
+        rr_network_write_api(&this->network, encoder.start,
+                             encoder.at - encoder.start);
     }
     break;
-    case LWS_CALLBACK_CLIENT_RECEIVE:
+    case rr_network_event_api_receive:
     {
         // parse incoming client data
         struct rr_binary_encoder decoder;
@@ -1395,62 +1341,150 @@ static int api_lws_callback(struct lws *ws, enum lws_callback_reasons reason,
         }
         break;
     }
-    case LWS_CALLBACK_CLIENT_CLOSED:
-        // uh oh
-        fprintf(stderr, "api ws disconnected\n");
-        abort();
-        break;
-    case LWS_CALLBACK_CLIENT_CONNECTION_ERROR:
-        fprintf(stderr, "api ws refused to connect\n");
-        abort();
-        break;
     default:
-        return 0;
+        break;
     }
-    return 0;
 }
 
-static int lws_callback(struct lws *ws, enum lws_callback_reasons reason,
-                        void *user, void *packet, size_t size)
+static void poll_network(struct rr_server *this)
 {
-    switch (reason)
+    struct rr_network_event event;
+    while (rr_network_poll(&this->network, &event))
     {
-    case LWS_CALLBACK_ESTABLISHED:
-    case LWS_CALLBACK_SERVER_WRITEABLE:
-    case LWS_CALLBACK_RECEIVE:
-    case LWS_CALLBACK_CLOSED:
-        break;
-    default:
-        return 0;
+        if (event.type == rr_network_event_api_connect ||
+            event.type == rr_network_event_api_receive)
+            handle_api_event(this, event.type, event.data);
+        else
+            handle_network_event(this, event.type, event.connection,
+                                 event.data, event.size);
+        free(event.data);
     }
-    // assert(pthread_mutex_lock(&mutex) == 0);
-
-    struct rr_server *this =
-        (struct rr_server *)lws_context_user(lws_get_context(ws));
-    int close = handle_lws_event(this, ws, reason, packet, size);
-    if (close)
-        return close;
-    // assert(pthread_mutex_unlock(&mutex) == 0);
-    return 0;
 }
 
-void *thread_func(void *arg)
+static void lws_log(int level, char const *log) { printf("%d %s", level, log); }
+
+static void write_squad_dump_message(struct rr_server_client *client,
+                                     struct proto_bug *encoder)
 {
-    struct rr_server *this = (struct rr_server *)arg;
-    while (1)
+    struct rr_server *server = client->server;
+    proto_bug_write_uint8(encoder, rr_clientbound_squad_dump, "header");
+    proto_bug_write_uint8(encoder, client->dev, "is_dev");
+    int8_t kick_vote_pos = -3;
+    if (client->in_squad)
     {
-        lws_service(this->server, 0);
+        kick_vote_pos = rr_squad_get_client_slot(server, client)->kick_vote_pos;
+        if (kick_vote_pos == -1 && client->ticks_to_next_kick_vote > 0)
+            kick_vote_pos = -2;
+    }
+    proto_bug_write_uint8(encoder, kick_vote_pos, "kick vote");
+    for (uint32_t s = 0; s < RR_SQUAD_COUNT; ++s)
+    {
+        struct rr_squad *squad = &server->squads[s];
+        for (uint32_t i = 0; i < RR_SQUAD_MEMBER_COUNT; ++i)
+        {
+            if (squad->members[i].in_use == 0)
+            {
+                proto_bug_write_uint8(encoder, 0, "bitbit");
+                continue;
+            }
+            struct rr_squad_member *member = &squad->members[i];
+            proto_bug_write_uint8(encoder, 1, "bitbit");
+            proto_bug_write_uint8(encoder, member->playing, "ready");
+            proto_bug_write_uint8(encoder, member->client->disconnected,
+                                  "disconnected");
+            uint8_t j = member->client - server->clients;
+            uint8_t blocked = rr_bitset_get(client->blocked_clients, j);
+            proto_bug_write_uint8(encoder, blocked, "blocked");
+            proto_bug_write_uint8(encoder, member->is_dev, "is_dev");
+            proto_bug_write_uint8(encoder, member->kick_vote_count,
+                                  "kick votes");
+            proto_bug_write_varuint(encoder, member->level, "level");
+            proto_bug_write_string(encoder, member->nickname, 16, "nickname");
+            for (uint8_t j = 0; j < RR_MAX_SLOT_COUNT * 2; ++j)
+            {
+                proto_bug_write_uint8(encoder, member->loadout[j].id, "id");
+                proto_bug_write_uint8(encoder, member->loadout[j].rarity,
+                                      "rar");
+            }
+        }
+        proto_bug_write_uint8(encoder, squad->owner, "sqown");
+        proto_bug_write_uint8(encoder, squad->private, "private");
+        proto_bug_write_uint8(encoder, squad->expose_code, "expose_code");
+        proto_bug_write_uint8(encoder, RR_GLOBAL_BIOME, "biome");
+        char joined_code[16];
+        if (client->dev || squad->expose_code ||
+            (client->in_squad && client->squad == s))
+            sprintf(joined_code, "%s-%s", server->server_alias,
+                    squad->squad_code);
+        else
+            strcpy(joined_code, "(private)");
+        proto_bug_write_string(encoder, joined_code, 16, "squad code");
     }
-    return 0;
 }
 
-static void lws_log(int level, char const *log) { printf("%d %s", level, log); }
+static void
+push_message(struct proto_bug *encoder, struct rr_server_client *client,
+             void (*writer)(struct rr_server_client *, struct proto_bug *))
+{
+    // the size goes in front but isn't known yet, write it over the
+    // placeholder after
+    struct proto_bug size = *encoder;
+    proto_bug_write_uint32(encoder, 0, "bundle size");
+    uint8_t *start = encoder->current;
+    writer(client, encoder);
+    proto_bug_write_uint32(&size, encoder->current - start, "bundle size");
+}
+
+// Runs on the worker pool. May only read the simulation and squads and write
+// to the state of its own client
+static void encode_client_job(uint32_t job, void *_captures)
+{
+    struct rr_server *this = _captures;
+    struct rr_server_client *client = &this->clients[this->encode_clients[job]];
+    struct rr_server_encode_state *state =
+        &this->encode_states[this->encode_clients[job]];
+    struct proto_bug encoder;
+    proto_bug_init_deferred(&encoder, state->buffer);
+    proto_bug_set_bound(&encoder, state->buffer + MESSAGE_BUFFER_SIZE);
+    state->size = 0;
+    // a client that hasn't received last tick's frames yet skips the update
+    // and squad dump, which are resent in full next tick. animations and
+    // chat only go out once so they are queued regardless
+    uint8_t lagging =
+        rr_network_sent_position(&this->network, client->connection) <
+        client->tick_frames_end;
+    proto_bug_write_uint8(&encoder, rr_clientbound_bundle, "header");
+    if (client->in_squad)
+    {
+        if (!lagging)
+            push_message(&encoder, client, write_update_message);
+        else if (client->player_info != NULL)
+            rr_simulation_skip_binary(&this->simulation, client->player_info,
+                                      &this->update_cache);
+    }
+    push_message(&encoder, client, write_animation_update_message);
+    if (!lagging)
+        push_message(&encoder, client, write_squad_dump_message);
+    // a cut off frame would desync the client, and the update already counted
+    // its entities as sent
+    if (encoder.overflowed)
+    {
+        fprintf(stderr, "<rr_server::frame_overflow::%s>\n",
+                client->rivet_account.uuid);
+        client->pending_kick = 1;
+        return;
+    }
+    proto_bug_finalize(&encoder);
+    state->size = encoder.current - encoder.start;
+    rr_server_client_encrypt_message(client, state->buffer, state->size);
+}
 
 static void server_tick(struct rr_server *this)
 {
     if (!this->api_ws_ready)
         return;
     rr_simulation_tick(&this->simulation);
+    this->encode_client_count = 0;
     for (uint64_t i = 0; i < RR_MAX_CLIENT_COUNT; ++i)
     {
         if (rr_bitset_get(this->clients_in_use, i))
@@ -1472,7 +1506,7 @@ static void server_tick(struct rr_server *this)
             }
             if (client->disconnected)
             {
-                if (++client->disconnected_ticks > 60 * 25)
+                if (++client->disconnected_ticks > 60 * RR_SERVER_TICK_RATE)
                 {
                     rr_bitset_unset(this->clients_in_use, i);
                     client->in_use = 0;
@@ -1485,7 +1519,7 @@ static void server_tick(struct rr_server *this)
                 !is_dead_flower(&this->simulation,
                                 client->player_info->flower_id))
             {
-                if (++client->afk_ticks > 10 * 60 * 25)
+                if (++client->afk_ticks > 10 * 60 * RR_SERVER_TICK_RATE)
                 {
                     rr_simulation_request_entity_deletion(
                         &this->simulation, client->player_info->parent_id);
@@ -1508,7 +1542,8 @@ static void server_tick(struct rr_server *this)
             else
                 client->afk_ticks = 0;
             if (client->pending_kick)
-                lws_callback_on_writable(client->socket_handle);
+                rr_network_kick(&this->network, client->connection,
+                                "kicked for unspecified reason");
             if (!client->verified)
                 continue;
             if (client->player_info != NULL)
@@ -1521,9 +1556,8 @@ static void server_tick(struct rr_server *this)
                         &this->simulation,
                         client->player_info->flower_id)->bubbling_to_death)
                     rr_vector_set(
-                        &rr_simulation_get_physical(
-                             &this->simulation, client->player_info->flower_id)
-                             ->acceleration,
+                        rr_simulation_get_acceleration(
+                            &this->simulation, client->player_info->flower_id),
                         client->player_accel_x, client->player_accel_y);
                 if (client->player_info->drops_this_tick_size > 0)
                 {
@@ -1540,158 +1574,46 @@ static void server_tick(struct rr_server *this)
                     client->player_info->drops_this_tick_size = 0;
                 }
             }
-            if (client->in_squad)
-                rr_server_client_broadcast_update(client);
-            rr_server_client_broadcast_animation_update(client);
-            // if (!client->dev)
-            //     continue;
-            struct proto_bug encoder;
-            proto_bug_init(&encoder, outgoing_message);
-            proto_bug_write_uint8(&encoder, rr_clientbound_squad_dump,
-                                  "header");
-            proto_bug_write_uint8(&encoder, client->dev, "is_dev");
-            int8_t kick_vote_pos = -3;
-            if (client->in_squad)
-            {
-                kick_vote_pos =
-                    rr_squad_get_client_slot(this, client)->kick_vote_pos;
-                if (kick_vote_pos == -1 && client->ticks_to_next_kick_vote > 0)
-                    kick_vote_pos = -2;
-            }
-            proto_bug_write_uint8(&encoder, kick_vote_pos, "kick vote");
-            for (uint32_t s = 0; s < RR_SQUAD_COUNT; ++s)
-            {
-                struct rr_squad *squad = &this->squads[s];
-                for (uint32_t i = 0; i < RR_SQUAD_MEMBER_COUNT; ++i)
-                {
-                    if (squad->members[i].in_use == 0)
-                    {
-                        proto_bug_write_uint8(&encoder, 0, "bitbit");
-                        continue;
-                    }
-                    struct rr_squad_member *member = &squad->members[i];
-                    proto_bug_write_uint8(&encoder, 1, "bitbit");
-                    proto_bug_write_uint8(&encoder, member->playing, "ready");
-                    proto_bug_write_uint8(&encoder,
-                                          member->client->disconnected,
-                                          "disconnected");
-                    uint8_t j = member->client - this->clients;
-                    uint8_t blocked = rr_bitset_get(client->blocked_clients, j);
-                    proto_bug_write_uint8(&encoder, blocked, "blocked");
-                    proto_bug_write_uint8(&encoder, member->is_dev, "is_dev");
-                    proto_bug_write_uint8(&encoder, member->kick_vote_count,
-                                          "kick votes");
-                    proto_bug_write_varuint(&encoder, member->level, "level");
-                    proto_bug_write_string(&encoder, member->nickname, 16,
-                                           "nickname");
-                    for (uint8_t j = 0; j < RR_MAX_SLOT_COUNT * 2; ++j)
-                    {
-                        proto_bug_write_uint8(&encoder, member->loadout[j].id,
-                                              "id");
-                        proto_bug_write_uint8(&encoder,
-                                              member->loadout[j].rarity, "rar");
-                    }
-                }
-                proto_bug_write_uint8(&encoder, squad->owner, "sqown");
-                proto_bug_write_uint8(&encoder, squad->private, "private");
-                proto_bug_write_uint8(&encoder, squad->expose_code,
-                                      "expose_code");
-                proto_bug_write_uint8(&encoder, RR_GLOBAL_BIOME, "biome");
-                char joined_code[16];
-                if (client->dev || squad->expose_code ||
-                    (client->in_squad && client->squad == s))
-                    sprintf(joined_code, "%s-%s", this->server_alias,
-                            squad->squad_code);
-                else
-                    strcpy(joined_code, "(private)");
-                proto_bug_write_string(&encoder, joined_code, 16, "squad code");
-            }
-            rr_server_client_write_message(client, encoder.start,
-                                           encoder.current - encoder.start);
+            if (client->player_info != NULL &&
+                !rr_simulation_entity_alive(&this->simulation,
+                                            client->player_info->arena))
+                rr_component_player_info_set_arena(client->player_info, 1);
+            if (this->encode_states[i].buffer == NULL)
+                this->encode_states[i].buffer = malloc(MESSAGE_BUFFER_SIZE);
+            this->encode_clients[this->encode_client_count++] = i;
         }
     }
+    rr_update_cache_begin_tick(&this->update_cache, &this->simulation);
+    rr_worker_pool_run(&this->worker_pool, this->encode_client_count, this,
+                       encode_client_job);
+    for (uint32_t i = 0; i < this->encode_client_count; ++i)
+    {
+        struct rr_server_client *client =
+            &this->clients[this->encode_clients[i]];
+        struct rr_server_encode_state *state =
+            &this->encode_states[this->encode_clients[i]];
+        if (state->size == 0)
+            continue;
+        rr_server_client_queue_message(client, state->buffer, state->size);
+        client->tick_frames_end = rr_network_write_position(
+            &this->network, client->connection);
+    }
     rr_simulation_for_each_entity(&this->simulation, &this->simulation,
                                   rr_simulation_tick_entity_resetter_function);
 }
 
 void rr_server_run(struct rr_server *this)
 {
-    {
-        struct lws_context_creation_info info = {0};
-
-        info.protocols =
-            (struct lws_protocols[]){{"g", lws_callback, sizeof(uint8_t),
-                                      MESSAGE_BUFFER_SIZE, 0, NULL, 0},
-                                     {0}};
-
-        info.port = 1234;
-        info.user = this;
-        info.pt_serv_buf_size = MESSAGE_BUFFER_SIZE;
-
-        this->server = lws_create_context(&info);
-        assert(this->server);
-    }
-    {
-        struct lws_context_creation_info info = {0};
-        struct lws_client_connect_info client_info = {0};
-
-        struct lws_protocols protocols[] = {
-            {
-                "g",
-                api_lws_callback,
-                0,
-                128 * 1024,
-            },
-            {NULL, NULL, 0, 0} // terminator
-        };
-        info.port = CONTEXT_PORT_NO_LISTEN;
-        info.protocols = protocols;
-        info.gid = -1;
-        info.uid = -1;
-        info.user = this;
-
-        this->api_client_context = lws_create_context(&info);
-        if (!this->api_client_context)
-        {
-            puts("couldn't create api server context");
-            exit(1);
-        }
-        client_info.context = this->api_client_context;
-        client_info.address =
-#ifndef RIVET_BUILD
-            "localhost";
-#else
-            "45.79.197.197";
-#endif
-        client_info.port = 55554;
-        client_info.path = "/api/" RR_API_SECRET;
-        client_info.host = client_info.address;
-        client_info.origin = client_info.address;
-        client_info.protocol = protocols[0].name;
-        this->api_client = lws_client_connect_via_info(&client_info);
-        if (!this->api_client)
-        {
-            puts("couldn't create api client");
-            exit(1);
-        }
-    }
-    struct timeval start;
-    struct timeval end;
+    rr_network_start(this);
+    rr_tick_scheduler_init(&this->tick_scheduler, RR_SERVER_TICK_RATE,
+                           RR_SERVER_MAX_CATCH_UP_TICKS);
     while (1)
     {
-        gettimeofday(&start, NULL);
-        lws_service(this->server, -1);
-        lws_service(this->api_client_context, -1);
+        rr_tick_scheduler_begin_tick(&this->tick_scheduler);
+        poll_network(this);
         server_tick(this);
         this->simulation.animation_length = 0;
-        gettimeofday(&end, NULL);
-
-        uint64_t elapsed_time = (end.tv_sec - start.tv_sec) * 1000000 +
-                                (end.tv_usec - start.tv_usec);
-        if (elapsed_time > 25000)
-            fprintf(stderr, "tick took %lu microseconds\n", elapsed_time);
-        int64_t to_sleep = 40000 - elapsed_time;
-        if (to_sleep > 0)
-            usleep(to_sleep);
+        rr_network_flush(&this->network);
+        rr_tick_scheduler_end_tick(&this->tick_scheduler);
     }
 }
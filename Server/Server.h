@@ -17,8 +17,12 @@
 #pragma once
 
 #include <Server/Client.h>
+#include <Server/Network.h>
 #include <Server/Simulation.h>
 #include <Server/Squad.h>
+#include <Server/TickScheduler.h>
+#include <Server/UpdateProtocol.h>
+#include <Server/WorkerPool.h>
 
 #ifndef NDEBUG
 #define MESSAGE_BUFFER_SIZE (32 * 1024 * 1024)
@@ -29,20 +33,36 @@
 extern uint8_t lws_message_data[MESSAGE_BUFFER_SIZE];
 extern uint8_t *outgoing_message;
 
-struct lws_context;
-struct lws;
 struct rr_server;
 struct rr_squad_member;
 
+#ifndef RR_SERVER_MAX_CATCH_UP_TICKS
+#define RR_SERVER_MAX_CATCH_UP_TICKS (5)
+#endif
+
+// Per-client scratch space for the bundle of messages encoded off the main
+// thread every tick. Kept outside of rr_server_client since that gets wiped on
+// connect
+struct rr_server_encode_state
+{
+    uint8_t *buffer;
+    // 0 if nothing was encoded this tick
+    uint64_t size;
+};
+
 struct rr_server
 {
     struct rr_simulation simulation;
     uint8_t clients_in_use[RR_BITSET_ROUND(RR_MAX_CLIENT_COUNT)];
     struct rr_server_client clients[RR_MAX_CLIENT_COUNT];
-    struct lws_context *server;
-    struct lws_context *api_client_context;
-    struct lws *api_client;
     struct rr_squad squads[RR_MAX_CLIENT_COUNT];
+    struct rr_server_encode_state encode_states[RR_MAX_CLIENT_COUNT];
+    uint8_t encode_clients[RR_MAX_CLIENT_COUNT];
+    uint32_t encode_client_count;
+    struct rr_update_cache update_cache;
+    struct rr_worker_pool worker_pool;
+    struct rr_network network;
+    struct rr_tick_scheduler tick_scheduler;
     uint8_t api_ws_ready;
     char server_alias[16];
 };
@@ -28,6 +28,7 @@
 #include <Server/EntityDetection.h>
 #include <Server/MobAi/Ai.h>
 #include <Server/SpatialHash.h>
+#include <Server/System/CollisionRules.h>
 #include <Server/System/System.h>
 #include <Server/Waves.h>
 #include <Shared/Bitset.h>
@@ -123,13 +124,17 @@ static void set_spawn_zones()
 
 void rr_simulation_init(struct rr_simulation *this)
 {
+    rr_simulation_free_component_pools(this);
     memset(this, 0, sizeof *this);
+    for (EntityIdx i = 0; i < RR_MAX_ENTITY_COUNT; ++i)
+        this->motion.acceleration_scale[i] = 1;
     EntityIdx id = rr_simulation_alloc_entity(this);
     struct rr_component_arena *arena = rr_simulation_add_arena(this, id);
     arena->biome = RR_GLOBAL_BIOME;
     rr_component_arena_spatial_hash_init(arena, this);
     set_respawn_zone(arena, SPAWN_ZONE_X, SPAWN_ZONE_Y);
     set_spawn_zones();
+    rr_collision_rules_init();
 }
 
 struct too_close_captures
@@ -147,13 +152,6 @@ static void too_close_cb(EntityIdx potential, void *_captures)
     if (captures->done)
         return;
     struct rr_simulation *simulation = captures->simulation;
-    if (!rr_simulation_has_mob(simulation, potential) &&
-            !rr_simulation_has_flower(simulation, potential) ||
-        rr_simulation_has_arena(simulation, potential))
-        return;
-    if (rr_simulation_get_relations(simulation, potential)->team ==
-        rr_simulation_team_id_mobs)
-        return;
     if (rr_simulation_get_health(simulation, potential)->health == 0)
         return;
     struct rr_component_physical *t_physical =
@@ -171,7 +169,13 @@ static int too_close(struct rr_simulation *this, float x, float y, float r)
     struct too_close_captures shg_captures = {this, x, y, r, 0};
     struct rr_spatial_hash *shg =
         &rr_simulation_get_arena(this, 1)->spatial_hash;
-    rr_spatial_hash_query(shg, x, y, r, r, &shg_captures, too_close_cb);
+    // flowers and mobs that are not on the mob team
+    struct rr_spatial_hash_filter filter = {
+        rr_component_mask_flower | rr_component_mask_mob,
+        rr_component_mask_arena, rr_simulation_team_id_mobs,
+        rr_spatial_hash_team_other};
+    rr_spatial_hash_query_circle(shg, x, y, r, &filter, &shg_captures,
+                                 too_close_cb);
     return shg_captures.done;
 }
 
@@ -287,8 +291,8 @@ static void despawn_mob(EntityIdx entity, void *_simulation)
                       arena->maze->maze_dim - 1))
             ->player_count == 0)
     {
-        if (mob->ticks_to_despawn > 30 * 25)
-            mob->ticks_to_despawn = 30 * 25;
+        if (mob->ticks_to_despawn > 30 * RR_SERVER_TICK_RATE)
+            mob->ticks_to_despawn = 30 * RR_SERVER_TICK_RATE;
         if (--mob->ticks_to_despawn == 0)
         {
             mob->no_drop = 1;
@@ -296,7 +300,7 @@ static void despawn_mob(EntityIdx entity, void *_simulation)
         }
     }
     else
-        mob->ticks_to_despawn = 30 * 25;
+        mob->ticks_to_despawn = 30 * RR_SERVER_TICK_RATE;
 }
 
 static float get_max_points(struct rr_simulation *this,
@@ -315,14 +319,16 @@ static int tick_grid(struct rr_simulation *this, struct rr_maze_grid *grid,
         rr_fclamp(grid->local_difficulty, -0.5, PLAYER_COUNT_CAP);
     if (grid->local_difficulty > 0)
     {
-        grid->overload_factor = rr_fclamp(
-            grid->overload_factor + 0.005 * grid->local_difficulty / 25, 0,
-            1.5 * grid->local_difficulty);
+        grid->overload_factor =
+            rr_fclamp(grid->overload_factor + 0.005 * grid->local_difficulty /
+                                                  RR_SERVER_TICK_RATE,
+                      0, 1.5 * grid->local_difficulty);
     }
     else
     {
-        grid->overload_factor = rr_fclamp(grid->overload_factor - 0.025 / 25, 0,
-                                          grid->overload_factor);
+        grid->overload_factor =
+            rr_fclamp(grid->overload_factor - 0.025 / RR_SERVER_TICK_RATE, 0,
+                      grid->overload_factor);
     }
     float player_modifier = 1 + grid->player_count * 4.0 / 3;
     float difficulty_modifier = 150 + 3 * grid->difficulty;
@@ -336,8 +342,8 @@ static int tick_grid(struct rr_simulation *this, struct rr_maze_grid *grid,
                      (player_modifier);
     if (grid->player_count == 0)
     {
-        grid->overload_factor =
-            rr_fclamp(grid->overload_factor - 0.025 / 25, 0, 15);
+        grid->overload_factor = rr_fclamp(
+            grid->overload_factor - 0.025 / RR_SERVER_TICK_RATE, 0, 15);
         grid->spawn_timer = rr_frand() * 0.75 * spawn_at;
     }
     else if (grid->spawn_timer >= spawn_at)
@@ -411,11 +417,71 @@ static void tick_maze(struct rr_simulation *this)
         CODE;                                                                  \
     };
 
+void rr_simulation_clear_contacts(struct rr_simulation *this)
+{
+    struct rr_simulation_contacts *contacts = &this->contacts;
+    for (uint32_t i = 0; i < contacts->touched_count; ++i)
+        contacts->counts[contacts->touched[i]] = 0;
+    contacts->touched_count = 0;
+    contacts->count = 0;
+}
+
+void rr_simulation_add_contact(struct rr_simulation *this, EntityIdx entity,
+                               EntityIdx other)
+{
+    struct rr_simulation_contacts *contacts = &this->contacts;
+    if (contacts->count == contacts->capacity)
+    {
+        contacts->capacity = contacts->capacity ? contacts->capacity * 2 : 1024;
+        contacts->pending =
+            realloc(contacts->pending,
+                    2 * contacts->capacity * sizeof *contacts->pending);
+        contacts->entities =
+            realloc(contacts->entities,
+                    contacts->capacity * sizeof *contacts->entities);
+        contacts->touched = realloc(
+            contacts->touched, contacts->capacity * sizeof *contacts->touched);
+    }
+    contacts->pending[2 * contacts->count] = entity;
+    contacts->pending[2 * contacts->count + 1] = other;
+    ++contacts->count;
+}
+
+void rr_simulation_sort_contacts(struct rr_simulation *this)
+{
+    struct rr_simulation_contacts *contacts = &this->contacts;
+    for (uint32_t i = 0; i < contacts->count; ++i)
+        if (contacts->counts[contacts->pending[2 * i]]++ == 0)
+            contacts->touched[contacts->touched_count++] =
+                contacts->pending[2 * i];
+    uint32_t start = 0;
+    for (uint32_t i = 0; i < contacts->touched_count; ++i)
+    {
+        EntityIdx entity = contacts->touched[i];
+        contacts->starts[entity] = start;
+        start += contacts->counts[entity];
+    }
+    for (uint32_t i = 0; i < contacts->count; ++i)
+        contacts->entities[contacts->starts[contacts->pending[2 * i]]++] =
+            contacts->pending[2 * i + 1];
+    for (uint32_t i = 0; i < contacts->touched_count; ++i)
+    {
+        EntityIdx entity = contacts->touched[i];
+        contacts->starts[entity] -= contacts->counts[entity];
+    }
+}
+
 static int64_t last_zone_epoch = -1;
 
+static void unset_entity(uint64_t entity, void *_captures)
+{
+    struct rr_simulation *this = _captures;
+    __rr_simulation_pending_deletion_unset_entity(entity, this);
+    rr_simulation_quarantine_entity(this, entity);
+}
+
 void rr_simulation_tick(struct rr_simulation *this)
 {
-    rr_simulation_create_component_vectors(this);
     RR_TIME_BLOCK("collision_detection",
                   { rr_system_collision_detection_tick(this); });
     RR_TIME_BLOCK("ai", { rr_system_ai_tick(this); });
@@ -439,23 +505,27 @@ void rr_simulation_tick(struct rr_simulation *this)
             this->deleted_last_tick + (RR_BITSET_ROUND(RR_MAX_ENTITY_COUNT)),
             this, __rr_simulation_pending_deletion_free_components);
     });
+    rr_simulation_release_quarantined_entities(this);
     RR_TIME_BLOCK("unset_entity", {
         rr_bitset_for_each_bit(
             this->deleted_last_tick,
             this->deleted_last_tick + RR_BITSET_ROUND(RR_MAX_ENTITY_COUNT),
-            this, __rr_simulation_pending_deletion_unset_entity);
+            this, unset_entity);
     });
 }
 
 int rr_simulation_entity_alive(struct rr_simulation *this, EntityHash hash)
 {
     return this->entity_tracker[(EntityIdx)hash] &&
-           this->entity_hash_tracker[(EntityIdx)hash] == (hash >> 16) &&
+           this->entity_hash_tracker[(EntityIdx)hash] ==
+               (hash >> RR_ENTITY_HASH_SHIFT) &&
            !rr_bitset_get(this->deleted_last_tick, (EntityIdx)hash);
 }
 
 EntityHash rr_simulation_get_entity_hash(struct rr_simulation *this,
                                          EntityIdx id)
 {
-    return ((uint32_t)(this->entity_hash_tracker[id]) << 16) | id;
+    return ((EntityHash)(this->entity_hash_tracker[id])
+            << RR_ENTITY_HASH_SHIFT) |
+           id;
 }
@@ -23,4 +23,9 @@ void rr_simulation_tick(struct rr_simulation *);
 int rr_simulation_entity_alive(struct rr_simulation *,
                                EntityHash); // stricter version
 
-EntityHash rr_simulation_get_entity_hash(struct rr_simulation *, EntityIdx);
\ No newline at end of file
+EntityHash rr_simulation_get_entity_hash(struct rr_simulation *, EntityIdx);
+void rr_simulation_clear_contacts(struct rr_simulation *);
+void rr_simulation_add_contact(struct rr_simulation *, EntityIdx, EntityIdx);
+// Groups the contacts added since the last clear by entity, keeping the order
+// they were added in
+void rr_simulation_sort_contacts(struct rr_simulation *);
@@ -19,19 +19,71 @@
 #include <math.h>
 #include <stdlib.h>
 #include <string.h>
+#if defined(__SSE2__) || defined(__AVX__)
+#include <immintrin.h>
+#endif
 
 #include <Shared/Bitset.h>
 #include <Shared/SimulationCommon.h>
 
-#define spatial_hash_get(x, y) &this->cells[(x) * this->size + (y)]
+#define spatial_hash_cell(x, y) ((x) * this->size + (y))
+#define for_each_in_cell(cell, i)                                              \
+    for (uint32_t i = this->cell_starts[cell];                                 \
+         i < this->cell_starts[cell] + this->cell_counts[cell]; ++i)
+
+// grids of arenas that got freed, handed out again by size. Only ever used
+// from the simulation thread
+static struct rr_spatial_hash spatial_hash_pool[RR_SPATIAL_HASH_POOL_SIZE];
+static uint32_t spatial_hash_pool_length = 0;
+
+static void free_spatial_hash(struct rr_spatial_hash *this)
+{
+    free(this->entities);
+    free(this->pending_entities);
+    free(this->pending_cells);
+    free(this->touched_cells);
+    free(this->cell_starts);
+    free(this->cell_counts);
+    free(this->cell_masks);
+    free(this->entity_masks);
+    free(this->xs);
+    free(this->ys);
+    free(this->radii);
+}
+
 void rr_spatial_hash_init(struct rr_spatial_hash *this,
                           struct rr_simulation *simulation, float size)
 {
     memset(this, 0, sizeof *this);
     this->size = (size + SPATIAL_HASH_GRID_SIZE - 0.1) / SPATIAL_HASH_GRID_SIZE;
     this->simulation = simulation;
-    this->cells =
-        calloc(sizeof(struct rr_spatial_hash_cell), this->size * this->size);
+    for (uint32_t i = 0; i < spatial_hash_pool_length; ++i)
+    {
+        if (spatial_hash_pool[i].size != this->size)
+            continue;
+        *this = spatial_hash_pool[i];
+        this->simulation = simulation;
+        spatial_hash_pool[i] = spatial_hash_pool[--spatial_hash_pool_length];
+        return;
+    }
+    // neighbours are looked up by start and count even if they were never
+    // filled, so both start out zeroed
+    this->cell_starts =
+        calloc(sizeof *this->cell_starts, this->size * this->size);
+    this->cell_counts =
+        calloc(sizeof *this->cell_counts, this->size * this->size);
+    this->cell_masks = calloc(sizeof *this->cell_masks, this->size * this->size);
+}
+
+void rr_spatial_hash_free(struct rr_spatial_hash *this)
+{
+    // pooled grids must come back with every cell empty
+    rr_spatial_hash_reset(this);
+    if (spatial_hash_pool_length < RR_SPATIAL_HASH_POOL_SIZE)
+        spatial_hash_pool[spatial_hash_pool_length++] = *this;
+    else
+        free_spatial_hash(this);
+    memset(this, 0, sizeof *this);
 }
 
 void rr_spatial_hash_insert(struct rr_spatial_hash *this, EntityIdx entity)
@@ -48,8 +100,82 @@ void rr_spatial_hash_insert(struct rr_spatial_hash *this, EntityIdx entity)
         rr_fclamp(physical->y, physical->radius,
                   this->size * SPATIAL_HASH_GRID_SIZE - physical->radius) /
         SPATIAL_HASH_GRID_SIZE;
-    struct rr_spatial_hash_cell *cell = spatial_hash_get(x, y);
-    cell->entities[cell->entities_in_use++] = entity;
+    if (x >= this->size)
+        x = this->size - 1;
+    if (y >= this->size)
+        y = this->size - 1;
+    if (this->entity_count == this->capacity)
+    {
+        // grows with the arena population instead of reserving every cell
+        this->capacity = this->capacity ? this->capacity * 2 : 64;
+        this->entities =
+            realloc(this->entities, this->capacity * sizeof *this->entities);
+        this->pending_entities =
+            realloc(this->pending_entities,
+                    this->capacity * sizeof *this->pending_entities);
+        this->pending_cells = realloc(
+            this->pending_cells, this->capacity * sizeof *this->pending_cells);
+        this->touched_cells = realloc(
+            this->touched_cells, this->capacity * sizeof *this->touched_cells);
+        this->entity_masks = realloc(
+            this->entity_masks, this->capacity * sizeof *this->entity_masks);
+        this->xs = realloc(this->xs, this->capacity * sizeof *this->xs);
+        this->ys = realloc(this->ys, this->capacity * sizeof *this->ys);
+        this->radii =
+            realloc(this->radii, this->capacity * sizeof *this->radii);
+    }
+    if (physical->radius > this->max_radius)
+        this->max_radius = physical->radius;
+    this->pending_entities[this->entity_count] = entity;
+    this->pending_cells[this->entity_count] = spatial_hash_cell(x, y);
+    ++this->entity_count;
+}
+
+static int compare_cells(void const *a, void const *b)
+{
+    uint32_t x = *(uint32_t const *)a;
+    uint32_t y = *(uint32_t const *)b;
+    return (x > y) - (x < y);
+}
+
+void rr_spatial_hash_build(struct rr_spatial_hash *this)
+{
+    for (uint32_t i = 0; i < this->entity_count; ++i)
+        if (this->cell_counts[this->pending_cells[i]]++ == 0)
+            this->touched_cells[this->touched_count++] =
+                this->pending_cells[i];
+    // sorted so neighbouring cells stay next to each other in memory
+    qsort(this->touched_cells, this->touched_count,
+          sizeof *this->touched_cells, compare_cells);
+    uint32_t start = 0;
+    for (uint32_t i = 0; i < this->touched_count; ++i)
+    {
+        uint32_t cell = this->touched_cells[i];
+        this->cell_starts[cell] = start;
+        start += this->cell_counts[cell];
+    }
+    // scattering bumps every start to the end of its cell, stable so cells
+    // keep their insertion order
+    for (uint32_t i = 0; i < this->entity_count; ++i)
+    {
+        uint32_t cell = this->pending_cells[i];
+        EntityIdx entity = this->pending_entities[i];
+        uint16_t mask = this->simulation->entity_tracker[entity];
+        struct rr_component_physical *physical =
+            rr_simulation_get_physical(this->simulation, entity);
+        uint32_t at = this->cell_starts[cell]++;
+        this->cell_masks[cell] |= mask;
+        this->entity_masks[at] = mask;
+        this->xs[at] = physical->x;
+        this->ys[at] = physical->y;
+        this->radii[at] = physical->radius;
+        this->entities[at] = entity;
+    }
+    for (uint32_t i = 0; i < this->touched_count; ++i)
+    {
+        uint32_t cell = this->touched_cells[i];
+        this->cell_starts[cell] -= this->cell_counts[cell];
+    }
 }
 
 void rr_spatial_hash_update(struct rr_spatial_hash *this, EntityIdx entity) {}
@@ -81,67 +207,197 @@ void rr_spatial_hash_query(struct rr_spatial_hash *this, float fx, float fy,
     for (uint32_t y = s_y; y <= e_y; y++)
         for (uint32_t x = s_x; x <= e_x; x++)
         {
-            struct rr_spatial_hash_cell *cell = spatial_hash_get(x, y);
-            for (uint64_t i = 0; i < cell->entities_in_use; i++)
-                cb(cell->entities[i], user_captures);
+            uint32_t cell = spatial_hash_cell(x, y);
+            for_each_in_cell(cell, i) cb(this->entities[i], user_captures);
         }
 }
 
+static void spatial_hash_query_filtered(struct rr_spatial_hash *this,
+                                       float fx, float fy, float fw, float fh,
+                                       uint8_t circle,
+                                       struct rr_spatial_hash_filter *filter,
+                                       void *user_captures,
+                                       void (*cb)(EntityIdx, void *))
+{
+    // entities sit in the cell their center had at build time, which can be
+    // the biggest radius in the grid away from the query area plus however
+    // far they moved since. a full cell covers the movement like it does in
+    // rr_spatial_hash_query
+    float pad = this->max_radius + SPATIAL_HASH_GRID_SIZE;
+    uint32_t s_x = rr_fclamp((fx - fw - pad) / SPATIAL_HASH_GRID_SIZE, 0,
+                             this->size - 1);
+    uint32_t s_y = rr_fclamp((fy - fh - pad) / SPATIAL_HASH_GRID_SIZE, 0,
+                             this->size - 1);
+    uint32_t e_x = rr_fclamp((fx + fw + pad) / SPATIAL_HASH_GRID_SIZE, 0,
+                             this->size - 1);
+    uint32_t e_y = rr_fclamp((fy + fh + pad) / SPATIAL_HASH_GRID_SIZE, 0,
+                             this->size - 1);
+
+    for (uint32_t y = s_y; y <= e_y; y++)
+        for (uint32_t x = s_x; x <= e_x; x++)
+        {
+            uint32_t cell = spatial_hash_cell(x, y);
+            if ((this->cell_masks[cell] & filter->include) == 0)
+                continue;
+            for_each_in_cell(cell, i)
+            {
+                uint16_t mask = this->entity_masks[i];
+                if ((mask & filter->include) == 0 || (mask & filter->exclude))
+                    continue;
+                EntityIdx entity = this->entities[i];
+                struct rr_component_physical *physical =
+                    rr_simulation_get_physical(this->simulation, entity);
+                float dx = physical->x - fx;
+                float dy = physical->y - fy;
+                if (circle)
+                {
+                    float reach = fw + physical->radius;
+                    if (dx * dx + dy * dy > reach * reach)
+                        continue;
+                }
+                else if (fabsf(dx) > fw + physical->radius ||
+                         fabsf(dy) > fh + physical->radius)
+                    continue;
+                if (filter->team_filter != rr_spatial_hash_team_any)
+                {
+                    uint8_t team =
+                        rr_simulation_get_relations(this->simulation, entity)
+                            ->team;
+                    if (is_same_team(team, filter->team) !=
+                        (filter->team_filter == rr_spatial_hash_team_same))
+                        continue;
+                }
+                cb(entity, user_captures);
+            }
+        }
+}
+
+void rr_spatial_hash_query_circle(struct rr_spatial_hash *this, float x,
+                                  float y, float r,
+                                  struct rr_spatial_hash_filter *filter,
+                                  void *user_captures,
+                                  void (*cb)(EntityIdx, void *))
+{
+    spatial_hash_query_filtered(this, x, y, r, r, 1, filter, user_captures,
+                                cb);
+}
+
+void rr_spatial_hash_query_box(struct rr_spatial_hash *this, float x, float y,
+                               float w, float h,
+                               struct rr_spatial_hash_filter *filter,
+                               void *user_captures,
+                               void (*cb)(EntityIdx, void *))
+{
+    spatial_hash_query_filtered(this, x, y, w, h, 0, filter, user_captures,
+                                cb);
+}
+
+// Calls cb for every entry in [j, end) whose circle overlaps entry i, in
+// order. The distance test runs several entries at a time so the callback only
+// ever sees pairs that are actually touching
+static void collide_with_run(struct rr_spatial_hash *this, uint32_t i,
+                             uint32_t j, uint32_t end, void *user_captures,
+                             void (*cb)(struct rr_simulation *, EntityIdx,
+                                        EntityIdx, void *))
+{
+    float const *xs = this->xs;
+    float const *ys = this->ys;
+    float const *radii = this->radii;
+    float x = xs[i];
+    float y = ys[i];
+    float radius = radii[i];
+#ifdef __AVX__
+    __m256 x8 = _mm256_set1_ps(x);
+    __m256 y8 = _mm256_set1_ps(y);
+    __m256 radius8 = _mm256_set1_ps(radius);
+    for (; j + 8 <= end; j += 8)
+    {
+        __m256 dx = _mm256_sub_ps(x8, _mm256_loadu_ps(xs + j));
+        __m256 dy = _mm256_sub_ps(y8, _mm256_loadu_ps(ys + j));
+        __m256 r = _mm256_add_ps(radius8, _mm256_loadu_ps(radii + j));
+        __m256 distance =
+            _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+        uint32_t hits = _mm256_movemask_ps(
+            _mm256_cmp_ps(distance, _mm256_mul_ps(r, r), _CMP_LT_OQ));
+        for (; hits; hits &= hits - 1)
+            cb(this->simulation, this->entities[i],
+               this->entities[j + __builtin_ctz(hits)], user_captures);
+    }
+#endif
+#ifdef __SSE2__
+    __m128 x4 = _mm_set1_ps(x);
+    __m128 y4 = _mm_set1_ps(y);
+    __m128 radius4 = _mm_set1_ps(radius);
+    for (; j + 4 <= end; j += 4)
+    {
+        __m128 dx = _mm_sub_ps(x4, _mm_loadu_ps(xs + j));
+        __m128 dy = _mm_sub_ps(y4, _mm_loadu_ps(ys + j));
+        __m128 r = _mm_add_ps(radius4, _mm_loadu_ps(radii + j));
+        __m128 distance = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        uint32_t hits =
+            _mm_movemask_ps(_mm_cmplt_ps(distance, _mm_mul_ps(r, r)));
+        for (; hits; hits &= hits - 1)
+            cb(this->simulation, this->entities[i],
+               this->entities[j + __builtin_ctz(hits)], user_captures);
+    }
+#endif
+    for (; j < end; ++j)
+    {
+        float dx = x - xs[j];
+        float dy = y - ys[j];
+        float r = radius + radii[j];
+        if (dx * dx + dy * dy < r * r)
+            cb(this->simulation, this->entities[i], this->entities[j],
+               user_captures);
+    }
+}
+
+#define collide_with_cell(adj)                                                 \
+    collide_with_run(this, i, this->cell_starts[adj],                          \
+                     this->cell_starts[adj] + this->cell_counts[adj],          \
+                     user_captures, cb)
+
 void rr_spatial_hash_find_possible_collisions(
     struct rr_spatial_hash *this, void *user_captures,
     void (*cb)(struct rr_simulation *, EntityIdx, EntityIdx, void *))
 {
-    for (uint64_t x = 0; x < this->size; ++x)
+    // touched cells are sorted, so this visits cells in the same order as a
+    // full sweep of the grid would
+    for (uint32_t t = 0; t < this->touched_count; ++t)
     {
-        for (uint64_t y = 0; y < this->size; ++y)
+        uint32_t cell = this->touched_cells[t];
+        uint32_t x = cell / this->size;
+        uint32_t y = cell % this->size;
+        uint32_t end = this->cell_starts[cell] + this->cell_counts[cell];
+        for_each_in_cell(cell, i)
         {
-            struct rr_spatial_hash_cell *cell = spatial_hash_get(x, y);
-            for (uint64_t i = 0; i < cell->entities_in_use; ++i)
+            collide_with_run(this, i, i + 1, end, user_captures, cb);
+            if (x > 0)
             {
-                for (uint64_t j = i + 1; j < cell->entities_in_use; ++j)
-                    cb(this->simulation, cell->entities[i], cell->entities[j],
-                       user_captures);
-                if (x > 0)
-                {
-                    struct rr_spatial_hash_cell *adj =
-                        spatial_hash_get(x - 1, y);
-                    for (uint64_t j = 0; j < adj->entities_in_use; ++j)
-                        cb(this->simulation, cell->entities[i],
-                           adj->entities[j], user_captures);
-                    if (y > 0)
-                    {
-                        struct rr_spatial_hash_cell *adj =
-                            spatial_hash_get(x - 1, y - 1);
-                        for (uint64_t j = 0; j < adj->entities_in_use; ++j)
-                            cb(this->simulation, cell->entities[i],
-                               adj->entities[j], user_captures);
-                    }
-                }
+                collide_with_cell(spatial_hash_cell(x - 1, y));
                 if (y > 0)
-                {
-                    struct rr_spatial_hash_cell *adj =
-                        spatial_hash_get(x, y - 1);
-                    for (uint64_t j = 0; j < adj->entities_in_use; ++j)
-                        cb(this->simulation, cell->entities[i],
-                           adj->entities[j], user_captures);
-                    if (x + 1 < this->size)
-                    {
-                        struct rr_spatial_hash_cell *adj =
-                            spatial_hash_get(x + 1, y - 1);
-                        for (uint64_t j = 0; j < adj->entities_in_use; ++j)
-                            cb(this->simulation, cell->entities[i],
-                               adj->entities[j], user_captures);
-                    }
-                }
+                    collide_with_cell(spatial_hash_cell(x - 1, y - 1));
+            }
+            if (y > 0)
+            {
+                collide_with_cell(spatial_hash_cell(x, y - 1));
+                if (x + 1 < this->size)
+                    collide_with_cell(spatial_hash_cell(x + 1, y - 1));
             }
         }
     }
 }
 
+#undef collide_with_cell
+
 void rr_spatial_hash_reset(struct rr_spatial_hash *this)
 {
-    for (uint64_t i = 0; i < this->size; i++)
-        for (uint64_t j = 0; j < this->size; j++)
-            this->cells[i * this->size + j].entities_in_use = 0;
-    // memset(&this->cells, 0, sizeof this->cells);
-}
\ No newline at end of file
+    for (uint32_t i = 0; i < this->touched_count; ++i)
+    {
+        this->cell_counts[this->touched_cells[i]] = 0;
+        this->cell_masks[this->touched_cells[i]] = 0;
+    }
+    this->touched_count = 0;
+    this->max_radius = 0;
+    this->entity_count = 0;
+}
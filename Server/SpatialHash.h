@@ -22,31 +22,79 @@
 #define SPATIAL_HASH_GRID_SIZE (1024)
 #define RR_SPATIAL_HASH_GRID_LENGTH                                            \
     (((RR_ARENA_LENGTH + SPATIAL_HASH_GRID_SIZE - 1) / SPATIAL_HASH_GRID_SIZE))
-#define RR_SPATIAL_HASH_CELL_MAX_ENTITY_COUNT (2048)
 
 struct rr_simulation;
 
-struct rr_spatial_hash_cell
+enum rr_spatial_hash_team_filter
 {
-    uint32_t entities_in_use;
-    EntityIdx entities[RR_SPATIAL_HASH_CELL_MAX_ENTITY_COUNT];
+    rr_spatial_hash_team_any,
+    rr_spatial_hash_team_same,
+    rr_spatial_hash_team_other
 };
 
+// Candidates need at least one of the components in include and none of the
+// ones in exclude (see rr_component_mask). Team is checked with is_same_team
+struct rr_spatial_hash_filter
+{
+    uint16_t include;
+    uint16_t exclude;
+    uint8_t team;
+    uint8_t team_filter;
+};
+
+// Number of released grids kept around for the next arena of the same size
+#define RR_SPATIAL_HASH_POOL_SIZE (32)
+
+// Rebuilt every tick. Inserts are staged in order and rr_spatial_hash_build
+// counting sorts them so each cell is one contiguous run of entities, cell i
+// being cell_counts[i] entities from entities[cell_starts[i]]. Only the
+// cells listed in touched_cells are non empty, which keeps build and reset
+// proportional to the population instead of the area
 struct rr_spatial_hash
 {
-    struct rr_spatial_hash_cell *cells;
+    EntityIdx *entities;
+    EntityIdx *pending_entities;
+    uint32_t *pending_cells;
+    uint32_t *touched_cells;
+    uint32_t *cell_starts;
+    uint32_t *cell_counts;
+    // components of every entity in the cell or run, set by build
+    uint16_t *cell_masks;
+    uint16_t *entity_masks;
+    // positions and radii parallel to entities, copied by build so the
+    // collision search can test several pairs at once
+    float *xs;
+    float *ys;
+    float *radii;
     struct rr_simulation *simulation;
+    float max_radius;
+    uint32_t entity_count;
+    uint32_t touched_count;
+    uint32_t capacity;
     uint32_t size;
 };
 
 void rr_spatial_hash_init(struct rr_spatial_hash *, struct rr_simulation *,
                           float);
+void rr_spatial_hash_free(struct rr_spatial_hash *);
 void rr_spatial_hash_insert(struct rr_spatial_hash *, EntityIdx);
+// Must run after the last insert and before any query or collision search
+void rr_spatial_hash_build(struct rr_spatial_hash *);
 void rr_spatial_hash_update(struct rr_spatial_hash *, EntityIdx);
 void rr_spatial_hash_query(struct rr_spatial_hash *, float, float, float, float,
                            void *, void (*)(EntityIdx, void *));
+// Only visits entities whose circle or box actually reaches the query area
+// and that pass the filter. Cells with none of the included components are
+// skipped without touching their entities
+void rr_spatial_hash_query_circle(struct rr_spatial_hash *, float, float, float,
+                                  struct rr_spatial_hash_filter *, void *,
+                                  void (*)(EntityIdx, void *));
+void rr_spatial_hash_query_box(struct rr_spatial_hash *, float, float, float,
+                               float, struct rr_spatial_hash_filter *, void *,
+                               void (*)(EntityIdx, void *));
+// Only reports pairs whose circles overlap, as of the last build
 void rr_spatial_hash_find_possible_collisions(struct rr_spatial_hash *, void *,
                                               void (*)(struct rr_simulation *,
                                                        EntityIdx, EntityIdx,
                                                        void *));
-void rr_spatial_hash_reset(struct rr_spatial_hash *);
\ No newline at end of file
+void rr_spatial_hash_reset(struct rr_spatial_hash *);
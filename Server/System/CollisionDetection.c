@@ -22,6 +22,7 @@
 #include <Server/Client.h>
 #include <Server/Simulation.h>
 #include <Server/SpatialHash.h>
+#include <Server/System/CollisionRules.h>
 #include <Shared/Bitset.h>
 
 struct physics_simulation_captures
@@ -30,7 +31,7 @@ struct physics_simulation_captures
     struct rr_component_physical *physical;
 };
 
-static void system_reset_colliding_with(EntityIdx entity, void *captures)
+static void system_check_owner_arena(EntityIdx entity, void *captures)
 {
     struct rr_simulation *this = captures;
     if (!rr_simulation_has_physical(this, entity))
@@ -38,7 +39,6 @@ static void system_reset_colliding_with(EntityIdx entity, void *captures)
 
     struct rr_component_physical *physical =
         rr_simulation_get_physical(this, entity);
-    physical->colliding_with_size = 0;
     EntityIdx owner = rr_simulation_get_relations(this, entity)->owner;
     if (rr_simulation_entity_alive(this, owner) &&
         rr_simulation_has_physical(this, owner))
@@ -63,31 +63,14 @@ static void system_insert_entities(EntityIdx entity, void *_captures)
 static uint8_t should_entities_collide(struct rr_simulation *this, EntityIdx a,
                                        EntityIdx b)
 {
-#define exclude(component_a, component_b)                                      \
-    if (rr_simulation_has_##component_a(this, a) &&                            \
-        rr_simulation_has_##component_b(this, b))                              \
-        return 0;                                                              \
-    if (rr_simulation_has_##component_a(this, b) &&                            \
-        rr_simulation_has_##component_b(this, a))                              \
+    uint8_t rule = rr_collision_rule(this, a, b);
+    if (rule & rr_collision_rule_detect)
+        return 1;
+    if (!(rule & rr_collision_rule_detect_other_team))
         return 0;
-    exclude(web, web);
-    exclude(web, petal);
-    exclude(drop, drop);
-    exclude(drop, mob);
-    exclude(nest, drop);
     uint8_t team1 = rr_simulation_get_relations(this, a)->team;
     uint8_t team2 = rr_simulation_get_relations(this, b)->team;
-    if (!is_same_team(team1, team2))
-        return 1; // only drop doesn't care about team
-    exclude(petal, petal);
-    exclude(petal, flower);
-    exclude(petal, mob);
-    exclude(nest, flower);
-    exclude(nest, petal);
-    exclude(nest, mob);
-#undef exclude
-
-    return 1;
+    return !is_same_team(team1, team2);
 }
 static void grid_filter_candidates(struct rr_simulation *this,
                                    EntityIdx entity1, EntityIdx entity2,
@@ -129,13 +112,7 @@ static void grid_filter_candidates(struct rr_simulation *this,
                               physical1->y - physical2->y};
     float collision_radius = physical1->radius + physical2->radius;
     if (rr_vector_magnitude_cmp(&delta, collision_radius) == -1)
-    {
-#ifndef RIVET_BUILD
-        if (physical1->colliding_with_size >= RR_MAX_COLLISION_COUNT)
-            puts("entity cram limit exceeded");
-#endif
-        physical1->colliding_with[physical1->colliding_with_size++] = entity2;
-    }
+        rr_simulation_add_contact(this, entity1, entity2);
 }
 
 static void collapse_arena(EntityIdx entity, void *_captures)
@@ -162,6 +139,7 @@ static void find_collisions(EntityIdx entity, void *_captures)
 {
     struct rr_simulation *this = _captures;
     struct rr_component_arena *arena = rr_simulation_get_arena(this, entity);
+    rr_spatial_hash_build(&arena->spatial_hash);
     rr_spatial_hash_find_possible_collisions(&arena->spatial_hash, NULL,
                                              grid_filter_candidates);
 }
@@ -169,7 +147,9 @@ static void find_collisions(EntityIdx entity, void *_captures)
 void rr_system_collision_detection_tick(struct rr_simulation *this)
 {
     rr_simulation_for_each_arena(this, this, collapse_arena);
-    rr_simulation_for_each_physical(this, this, system_reset_colliding_with);
+    rr_simulation_for_each_physical(this, this, system_check_owner_arena);
+    rr_simulation_clear_contacts(this);
     rr_simulation_for_each_physical(this, this, system_insert_entities);
     rr_simulation_for_each_arena(this, this, find_collisions);
+    rr_simulation_sort_contacts(this);
 }
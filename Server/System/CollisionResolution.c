@@ -20,31 +20,13 @@
 #include <string.h>
 
 #include <Server/Simulation.h>
+#include <Server/System/CollisionRules.h>
 #include <Shared/Bitset.h>
 
 static uint8_t should_entities_collide(struct rr_simulation *this, EntityIdx a,
                                        EntityIdx b)
 {
-#define exclude(component_a, component_b)                                      \
-    if (rr_simulation_has_##component_a(this, a) &&                            \
-        rr_simulation_has_##component_b(this, b))                              \
-        return 0;                                                              \
-    if (rr_simulation_has_##component_a(this, b) &&                            \
-        rr_simulation_has_##component_b(this, a))                              \
-        return 0;
-
-    exclude(drop, petal);
-    exclude(drop, flower);
-    exclude(arena, petal);
-    exclude(arena, mob);
-    uint8_t team1 = rr_simulation_get_relations(this, a)->team;
-    uint8_t team2 = rr_simulation_get_relations(this, b)->team;
-    if (!is_same_team(team1, team2))
-        return 1; // only drop doesn't care about team
-
-#undef exclude
-
-    return 1;
+    return rr_collision_rule(this, a, b) & rr_collision_rule_resolve;
 }
 
 struct colliding_with_captures
@@ -88,8 +70,8 @@ static void enter_arena(struct rr_simulation *this, EntityIdx arena,
         physical, respawn_zone->x + 2 * a->maze->grid_size * rr_frand());
     rr_component_physical_set_y(
         physical, respawn_zone->y + 2 * a->maze->grid_size * rr_frand());
-    rr_vector_set(&physical->velocity, 0, 0);
-    rr_vector_set(&physical->collision_velocity, 0, 0);
+    rr_vector_set(rr_simulation_get_velocity(this, enterer), 0, 0);
+    rr_vector_set(rr_simulation_get_collision_velocity(this, enterer), 0, 0);
     a->first_squad_to_enter = player_info->squad;
     a->player_entered = 1;
 }
@@ -179,50 +161,54 @@ static void colliding_with_function(uint64_t i, void *_captures)
     }
     {
         float overlap = (distance - physical1->radius - physical2->radius);
-        physical1->collision_velocity.x +=
-            overlap * delta.x / distance * v1_coeff;
-        physical1->collision_velocity.y +=
-            overlap * delta.y / distance * v1_coeff;
-        physical2->collision_velocity.x -=
-            overlap * delta.x / distance * v2_coeff;
-        physical2->collision_velocity.y -=
-            overlap * delta.y / distance * v2_coeff;
+        struct rr_vector *collision_velocity1 =
+            rr_simulation_get_collision_velocity(this, entity1);
+        struct rr_vector *collision_velocity2 =
+            rr_simulation_get_collision_velocity(this, entity2);
+        collision_velocity1->x += overlap * delta.x / distance * v1_coeff;
+        collision_velocity1->y += overlap * delta.y / distance * v1_coeff;
+        collision_velocity2->x -= overlap * delta.x / distance * v2_coeff;
+        collision_velocity2->y -= overlap * delta.y / distance * v2_coeff;
     }
 
     {
 /*
 #define RESTITUTION 0.25f
 rr_vector_normalize(&delta);
-float vel_1 = (delta.x + physical1->velocity.x + delta.y +
-physical1->velocity.y); float vel_2 = (delta.x + physical2->velocity.x + delta.y
-+ physical2->velocity.y); if (vel_2 > vel_1) return; v1_coeff *= 2; v2_coeff *=
+float vel_1 = (delta.x + physical1->velocity->x + delta.y +
+physical1->velocity->y); float vel_2 = (delta.x + physical2->velocity->x + delta.y
++ physical2->velocity->y); if (vel_2 > vel_1) return; v1_coeff *= 2; v2_coeff *=
 2; float vshared_coeff = (physical2->mass - physical1->mass) / (physical1->mass
 + physical2->mass); float vf_1 = -vshared_coeff * vel_1 + v1_coeff * vel_2;
 float vf_2 = vshared_coeff * vel_2 + v2_coeff * vel_1;
 
-physical1->collision_velocity.x += (vf_1 * RESTITUTION) * delta.x *
-physical2->knockback_scale; physical1->collision_velocity.y += (vf_1 *
+physical1->collision_velocity->x += (vf_1 * RESTITUTION) * delta.x *
+physical2->knockback_scale; physical1->collision_velocity->y += (vf_1 *
 RESTITUTION) * delta.y * physical2->knockback_scale;
-physical2->collision_velocity.x += (vf_2 * RESTITUTION) * delta.x *
-physical1->knockback_scale; physical2->collision_velocity.y += (vf_2 *
+physical2->collision_velocity->x += (vf_2 * RESTITUTION) * delta.x *
+physical1->knockback_scale; physical2->collision_velocity->y += (vf_2 *
 RESTITUTION) * delta.y * physical1->knockback_scale;
 //removing the parallel components
-physical1->velocity.x -= delta.x * vel_1;
-physical1->velocity.y -= delta.x * vel_1;
-physical2->velocity.x -= delta.x * vel_2;
-physical2->velocity.y -= delta.x * vel_2;
+physical1->velocity->x -= delta.x * vel_1;
+physical1->velocity->y -= delta.x * vel_1;
+physical2->velocity->x -= delta.x * vel_2;
+physical2->velocity->y -= delta.x * vel_2;
 */
 // printf("%f %f\n", vf_1, vf_2);
 #define KNOCKBACK_CONST (8.0f / 2)
         rr_vector_normalize(&delta);
-        physical1->acceleration.x -=
+        struct rr_vector *acceleration1 =
+            rr_simulation_get_acceleration(this, entity1);
+        struct rr_vector *acceleration2 =
+            rr_simulation_get_acceleration(this, entity2);
+        acceleration1->x -=
             v1_coeff * KNOCKBACK_CONST * delta.x * physical2->knockback_scale;
-        physical1->acceleration.y -=
+        acceleration1->y -=
             v1_coeff * KNOCKBACK_CONST * delta.y * physical2->knockback_scale;
-        physical2->acceleration.x -= (v1_coeff - 1) * KNOCKBACK_CONST * delta.x *
-                                     physical1->knockback_scale;
-        physical2->acceleration.y -= (v1_coeff - 1) * KNOCKBACK_CONST * delta.y *
-                                     physical1->knockback_scale;
+        acceleration2->x -= (v1_coeff - 1) * KNOCKBACK_CONST * delta.x *
+                            physical1->knockback_scale;
+        acceleration2->y -= (v1_coeff - 1) * KNOCKBACK_CONST * delta.y *
+                            physical1->knockback_scale;
 #undef KNOCKBACK_CONST
     }
 }
@@ -238,17 +224,17 @@ static void system_for_each_function(EntityIdx entity, void *_captures)
     captures.physical = physical;
     captures.simulation = this;
 
-    for (uint64_t i = 0; i < physical->colliding_with_size; ++i)
-        colliding_with_function(physical->colliding_with[i], &captures);
+    struct rr_simulation_contacts *contacts = &this->contacts;
+    EntityIdx *colliding_with = contacts->entities + contacts->starts[entity];
+    for (uint32_t i = 0; i < contacts->counts[entity]; ++i)
+        colliding_with_function(colliding_with[i], &captures);
 }
 
 static void system_reset_collision_velocity(EntityIdx entity, void *_captures)
 {
     struct rr_simulation *this = _captures;
 
-    struct rr_component_physical *physical =
-        rr_simulation_get_physical(this, entity);
-    rr_vector_set(&physical->collision_velocity, 0, 0);
+    rr_vector_set(rr_simulation_get_collision_velocity(this, entity), 0, 0);
 }
 
 void rr_system_collision_resolution_tick(struct rr_simulation *this)
@@ -0,0 +1,112 @@
+// Copyright (C) 2024 Paul Johnson
+// Copyright (C) 2024-2025 Maxim Nesterov
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <Server/System/CollisionRules.h>
+
+#include <string.h>
+
+uint8_t rr_collision_signatures[2][256];
+uint8_t rr_collision_rules[RR_COLLISION_SIGNATURE_COUNT]
+                          [RR_COLLISION_SIGNATURE_COUNT];
+
+// every component some collision rule checks for, one signature bit each
+static uint16_t const signature_components[] = {
+    rr_component_mask_web,   rr_component_mask_petal, rr_component_mask_drop,
+    rr_component_mask_mob,   rr_component_mask_nest,  rr_component_mask_flower,
+    rr_component_mask_arena};
+
+static uint16_t signature_to_mask(uint8_t signature)
+{
+    uint16_t mask = 0;
+    for (uint32_t i = 0; i < sizeof signature_components / sizeof(uint16_t);
+         ++i)
+        if (signature & (1 << i))
+            mask |= signature_components[i];
+    return mask;
+}
+
+#define exclude(component_a, component_b)                                      \
+    if ((a & rr_component_mask_##component_a) &&                               \
+        (b & rr_component_mask_##component_b))                                 \
+        return 0;                                                              \
+    if ((b & rr_component_mask_##component_a) &&                               \
+        (a & rr_component_mask_##component_b))                                 \
+        return 0;
+
+static uint8_t detect_across_teams(uint16_t a, uint16_t b)
+{
+    exclude(web, web);
+    exclude(web, petal);
+    exclude(drop, drop);
+    exclude(drop, mob);
+    exclude(nest, drop);
+    return 1;
+}
+
+static uint8_t detect_within_team(uint16_t a, uint16_t b)
+{
+    if (!detect_across_teams(a, b))
+        return 0;
+    exclude(petal, petal);
+    exclude(petal, flower);
+    exclude(petal, mob);
+    exclude(nest, flower);
+    exclude(nest, petal);
+    exclude(nest, mob);
+    return 1;
+}
+
+static uint8_t resolve(uint16_t a, uint16_t b)
+{
+    exclude(drop, petal);
+    exclude(drop, flower);
+    exclude(arena, petal);
+    exclude(arena, mob);
+#undef exclude
+    return 1;
+}
+
+void rr_collision_rules_init(void)
+{
+    memset(rr_collision_signatures, 0, sizeof rr_collision_signatures);
+    for (uint32_t i = 0; i < sizeof signature_components / sizeof(uint16_t);
+         ++i)
+    {
+        uint16_t mask = signature_components[i];
+        if (mask & 255)
+            for (uint32_t byte = 0; byte < 256; ++byte)
+                if (byte & mask)
+                    rr_collision_signatures[0][byte] |= 1 << i;
+        if (mask >> 8)
+            for (uint32_t byte = 0; byte < 256; ++byte)
+                if (byte & (mask >> 8))
+                    rr_collision_signatures[1][byte] |= 1 << i;
+    }
+    for (uint32_t i = 0; i < RR_COLLISION_SIGNATURE_COUNT; ++i)
+        for (uint32_t j = 0; j < RR_COLLISION_SIGNATURE_COUNT; ++j)
+        {
+            uint16_t a = signature_to_mask(i);
+            uint16_t b = signature_to_mask(j);
+            uint8_t rule = 0;
+            if (detect_within_team(a, b))
+                rule |= rr_collision_rule_detect;
+            else if (detect_across_teams(a, b))
+                rule |= rr_collision_rule_detect_other_team;
+            if (resolve(a, b))
+                rule |= rr_collision_rule_resolve;
+            rr_collision_rules[i][j] = rule;
+        }
+}
@@ -0,0 +1,56 @@
+// Copyright (C) 2024 Paul Johnson
+// Copyright (C) 2024-2025 Maxim Nesterov
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <Server/Simulation.h>
+
+// Which of the collision systems care about a pair, decided only by the
+// components both entities have. rr_collision_rule_detect_other_team pairs
+// only collide when the two are on different teams
+enum rr_collision_rule
+{
+    rr_collision_rule_detect = 1,
+    rr_collision_rule_detect_other_team = 2,
+    rr_collision_rule_resolve = 4
+};
+
+// entities are grouped by the components the rules look at, folded into 7
+// bits through one table per byte of the entity tracker
+#define RR_COLLISION_SIGNATURE_COUNT (128)
+
+extern uint8_t rr_collision_signatures[2][256];
+extern uint8_t rr_collision_rules[RR_COLLISION_SIGNATURE_COUNT]
+                                 [RR_COLLISION_SIGNATURE_COUNT];
+
+void rr_collision_rules_init(void);
+
+static inline uint8_t rr_collision_signature(struct rr_simulation *this,
+                                             EntityIdx entity)
+{
+    uint16_t tracker = this->entity_tracker[entity];
+    return rr_collision_signatures[0][tracker & 255] |
+           rr_collision_signatures[1][tracker >> 8];
+}
+
+static inline uint8_t rr_collision_rule(struct rr_simulation *this,
+                                        EntityIdx a, EntityIdx b)
+{
+    return rr_collision_rules[rr_collision_signature(this, a)]
+                             [rr_collision_signature(this, b)];
+}
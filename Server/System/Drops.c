@@ -20,6 +20,7 @@
 
 #include <Server/Client.h>
 #include <Server/Simulation.h>
+#include <Server/TickScheduler.h>
 
 struct drop_pick_up_captures
 {
@@ -36,7 +37,8 @@ static void drop_cb(EntityIdx entity, void *_captures)
     struct rr_simulation *this = captures->simulation;
 
     struct rr_component_drop *drop = rr_simulation_get_drop(this, entity);
-    if (drop->ticks_until_despawn > 25 * 10 * (drop->rarity + 1) - 10)
+    if (drop->ticks_until_despawn >
+        RR_SERVER_TICK_RATE * 10 * (drop->rarity + 1) - 10)
         return;
     if (drop->ticks_until_despawn == 0)
         return;
@@ -87,9 +89,11 @@ static void drop_pick_up(EntityIdx entity, void *_captures)
     captures.closest_dist =
         flower_physical->radius + player_info->modifiers.drop_pickup_radius;
     captures.closest_drop = RR_NULL_ENTITY;
-    rr_spatial_hash_query(&arena->spatial_hash, flower_physical->x,
-                          flower_physical->y, captures.closest_dist,
-                          captures.closest_dist, &captures, drop_cb);
+    struct rr_spatial_hash_filter filter = {rr_component_mask_drop, 0, 0,
+                                            rr_spatial_hash_team_any};
+    rr_spatial_hash_query_circle(&arena->spatial_hash, flower_physical->x,
+                                 flower_physical->y, captures.closest_dist,
+                                 &filter, &captures, drop_cb);
     if (captures.closest_drop == RR_NULL_ENTITY)
         return;
 
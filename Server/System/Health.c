@@ -23,6 +23,7 @@
 #include <Server/Client.h>
 #include <Server/EntityDetection.h>
 #include <Server/Simulation.h>
+#include <Server/TickScheduler.h>
 #include <Shared/Bitset.h>
 
 struct colliding_with_captures
@@ -291,7 +292,7 @@ static uint8_t damage_effect(struct rr_simulation *simulation, EntityIdx target,
             struct rr_component_physical *physical =
                 rr_simulation_get_physical(simulation, target);
             physical->stun_ticks =
-                25 *
+                RR_SERVER_TICK_RATE *
                 (1 + sqrtf(RR_PETAL_RARITY_SCALE[petal->rarity].heal) / 3) *
                 (1 - physical->slow_resist);
         }
@@ -368,10 +369,6 @@ static void colliding_with_function(uint64_t i, void *_captures)
 static void system_for_each_function(EntityIdx entity, void *_captures)
 {
     struct rr_simulation *this = _captures;
-    // all health has physical
-
-    struct rr_component_physical *physical =
-        rr_simulation_get_physical(this, entity);
     struct rr_component_health *health = rr_simulation_get_health(this, entity);
 
     if (health->health == 0)
@@ -381,8 +378,10 @@ static void system_for_each_function(EntityIdx entity, void *_captures)
     captures.health = health;
     captures.simulation = this;
 
-    for (uint32_t i = 0; i < physical->colliding_with_size; ++i)
-        colliding_with_function(physical->colliding_with[i], &captures);
+    struct rr_simulation_contacts *contacts = &this->contacts;
+    EntityIdx *colliding_with = contacts->entities + contacts->starts[entity];
+    for (uint32_t i = 0; i < contacts->counts[entity]; ++i)
+        colliding_with_function(colliding_with[i], &captures);
 }
 
 void rr_system_health_tick(struct rr_simulation *this)
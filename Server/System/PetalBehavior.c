@@ -256,7 +256,7 @@ static void system_flower_petal_movement_logic(
             system_petal_detach(simulation, petal, player_info, outer_pos,
                                 inner_pos, petal_data);
             petal->effect_delay = 75;
-            physical->friction = 0.5;
+            *rr_simulation_get_friction(simulation, id) = 0.5;
             physical->bearing_angle = curr_angle;
             EntityIdx target = rr_simulation_find_nearest_enemy(
                 simulation, id, 750, NULL, is_close_enough_and_angle);
@@ -276,9 +276,10 @@ static void system_flower_petal_movement_logic(
                 break;
             system_petal_detach(simulation, petal, player_info, outer_pos,
                                 inner_pos, petal_data);
-            rr_vector_from_polar(&physical->acceleration, 4.0f,
-                                 physical->angle);
-            rr_vector_from_polar(&physical->velocity, 50.0f, physical->angle);
+            rr_vector_from_polar(rr_simulation_get_acceleration(simulation, id),
+                                 4.0f, physical->angle);
+            rr_vector_from_polar(rr_simulation_get_velocity(simulation, id),
+                                 50.0f, physical->angle);
             petal->effect_delay = 38;
             uint32_t count = petal_data->count[petal->rarity];
             for (uint32_t i = 1; i < count; ++i)
@@ -290,10 +291,12 @@ static void system_flower_petal_movement_logic(
                     rr_simulation_get_physical(simulation, new_petal);
                 rr_component_physical_set_angle(
                     new_physical, physical->angle + i * 2 * M_PI / count);
-                rr_vector_from_polar(&new_physical->acceleration, 4.0f,
-                                     new_physical->angle);
-                rr_vector_from_polar(&new_physical->velocity, 50.0f,
-                                     new_physical->angle);
+                rr_vector_from_polar(
+                    rr_simulation_get_acceleration(simulation, new_petal), 4.0f,
+                    new_physical->angle);
+                rr_vector_from_polar(
+                    rr_simulation_get_velocity(simulation, new_petal), 50.0f,
+                    new_physical->angle);
                 rr_component_petal_set_detached(
                     rr_simulation_get_petal(simulation, new_petal), 1);
                 rr_simulation_get_petal(simulation, new_petal)->effect_delay =
@@ -335,7 +338,9 @@ static void system_flower_petal_movement_logic(
                 else
                 {
                     rr_vector_scale(&delta, 0.4);
-                    rr_vector_add(&physical->acceleration, &delta);
+                    rr_vector_add(rr_simulation_get_acceleration(simulation,
+                                                                 id),
+                                  &delta);
                     return;
                 }
             }
@@ -386,7 +391,9 @@ static void system_flower_petal_movement_logic(
                     else
                     {
                         rr_vector_scale(&delta, 0.4);
-                        rr_vector_add(&physical->acceleration, &delta);
+                        rr_vector_add(rr_simulation_get_acceleration(simulation,
+                                                                     id),
+                                      &delta);
                         return;
                     }
                 }
@@ -401,8 +408,11 @@ static void system_flower_petal_movement_logic(
                                 inner_pos, petal_data);
             if (player_info->input & 1)
             {
-                rr_vector_from_polar(&physical->acceleration, 7.5f, curr_angle);
-                rr_vector_from_polar(&physical->velocity, 50.0f, curr_angle);
+                rr_vector_from_polar(rr_simulation_get_acceleration(simulation,
+                                                                    id),
+                                     7.5f, curr_angle);
+                rr_vector_from_polar(rr_simulation_get_velocity(simulation, id),
+                                     50.0f, curr_angle);
             }
             petal->effect_delay = 20;
             break;
@@ -414,8 +424,11 @@ static void system_flower_petal_movement_logic(
             rr_component_petal_set_detached(petal, 1);
             if (player_info->input & 1)
             {
-                rr_vector_from_polar(&physical->acceleration, 7.5f, curr_angle);
-                rr_vector_from_polar(&physical->velocity, 50.0f, curr_angle);
+                rr_vector_from_polar(rr_simulation_get_acceleration(simulation,
+                                                                    id),
+                                     7.5f, curr_angle);
+                rr_vector_from_polar(rr_simulation_get_velocity(simulation, id),
+                                     50.0f, curr_angle);
             }
             petal->effect_delay = 500;
             break;
@@ -424,7 +437,7 @@ static void system_flower_petal_movement_logic(
         {
             if ((player_info->input & 2) == 0)
                 break;
-            petal->effect_delay = 15 * 25;
+            petal->effect_delay = 15 * RR_SERVER_TICK_RATE;
             rr_component_petal_set_detached(petal, 1);
             break;
         }
@@ -465,7 +478,8 @@ static void system_flower_petal_movement_logic(
                     (target_physical->radius - physical->radius) * rr_frand(),
                     2 * M_PI * rr_frand());
                 petal->effect_delay =
-                    25 * RR_PETAL_RARITY_SCALE[petal->rarity].seed_cooldown;
+                    RR_SERVER_TICK_RATE *
+                    RR_PETAL_RARITY_SCALE[petal->rarity].seed_cooldown;
                 rr_component_petal_set_detached(petal, 1);
             }
             break;
@@ -477,7 +491,7 @@ static void system_flower_petal_movement_logic(
             system_petal_detach(simulation, petal, player_info, outer_pos,
                                 inner_pos, petal_data);
             petal->effect_delay = 65;
-            physical->friction = 0.4;
+            *rr_simulation_get_friction(simulation, id) = 0.4;
             break;
         }
         case rr_petal_id_mint:
@@ -515,7 +529,8 @@ static void system_flower_petal_movement_logic(
             else
             {
                 rr_vector_scale(&delta, 0.4);
-                rr_vector_add(&physical->acceleration, &delta);
+                rr_vector_add(rr_simulation_get_acceleration(simulation, id),
+                              &delta);
                 return;
             }
             break;
@@ -537,11 +552,14 @@ static void system_flower_petal_movement_logic(
                 if (flower_physical->bubbling_to_death)
                 {
                     rr_vector_set_magnitude(&accel, RR_PLAYER_SPEED * 100);
-                    flower_physical->friction = 1;
+                    *rr_simulation_get_friction(
+                        simulation, flower_physical->parent_id) = 1;
                 }
                 else
                     rr_vector_set_magnitude(&accel, 25 * (petal->rarity + 1));
-                rr_vector_add(&flower_physical->acceleration, &accel);
+                rr_vector_add(rr_simulation_get_acceleration(
+                                  simulation, flower_physical->parent_id),
+                              &accel);
             }
             break;
         }
@@ -597,12 +615,14 @@ static void system_flower_petal_movement_logic(
         rr_vector_from_polar(&random_vector, 10.0f, rr_frand() * M_PI * 2);
         rr_vector_add(&chase_vector, &random_vector);
     }
-    physical->acceleration.x += 0.5f * chase_vector.x;
-    physical->acceleration.y += 0.5f * chase_vector.y;
+    struct rr_vector *acceleration =
+        rr_simulation_get_acceleration(simulation, id);
+    acceleration->x += 0.5f * chase_vector.x;
+    acceleration->y += 0.5f * chase_vector.y;
     if (petal->id == rr_petal_id_fireball &&
-        rr_vector_magnitude_cmp(&physical->acceleration, 1.0f) == 1)
-        rr_component_physical_set_angle(
-            physical, rr_vector_theta(&physical->acceleration));
+        rr_vector_magnitude_cmp(acceleration, 1.0f) == 1)
+        rr_component_physical_set_angle(physical,
+                                        rr_vector_theta(acceleration));
     else
         rr_component_physical_set_angle(
             physical, physical->angle + 0.04f * petal->spin_ccw *
@@ -620,7 +640,7 @@ static void petal_modifiers(struct rr_simulation *simulation,
         rr_simulation_get_health(simulation, player_info->flower_id);
     rr_component_flower_set_face_flags(flower, player_info->input);
     // reset
-    physical->acceleration_scale = 1;
+    *rr_simulation_get_acceleration_scale(simulation, physical->parent_id) = 1;
     player_info->modifiers.drop_pickup_radius = 25;
     player_info->modifiers.petal_extension = 0;
     player_info->modifiers.reload_speed = 1;
@@ -657,7 +677,8 @@ static void petal_modifiers(struct rr_simulation *simulation,
         }
         else if (data->id == rr_petal_id_feather)
         {
-            physical->acceleration_scale +=
+            *rr_simulation_get_acceleration_scale(simulation,
+                                                  physical->parent_id) +=
                 (0.05 + 0.025 * slot->rarity) * feather_diminish_factor;
             feather_diminish_factor *= 0.5;
         }
@@ -834,7 +855,8 @@ static void system_nest_egg_movement_logic(struct rr_simulation *simulation,
     rr_vector_add(&chase_vector, &nest_vector);
     rr_vector_sub(&chase_vector, &position_vector);
     rr_vector_scale(&chase_vector, 0.25);
-    rr_vector_add(&physical->acceleration, &chase_vector);
+    rr_vector_add(rr_simulation_get_acceleration(simulation, id),
+                  &chase_vector);
 }
 
 static void rr_system_petal_reload_foreach_function(EntityIdx id,
@@ -992,12 +1014,12 @@ static void system_petal_misc_logic(EntityIdx id, void *_simulation)
         {
             rr_component_physical_set_angle(
                 physical, physical->angle + 0.12f * (float)petal->spin_ccw);
-            rr_vector_from_polar(&physical->acceleration, 15.0f,
-                                 physical->bearing_angle);
+            rr_vector_from_polar(rr_simulation_get_acceleration(simulation, id),
+                                 15.0f, physical->bearing_angle);
         }
         else if (petal->id == rr_petal_id_peas)
-            rr_vector_from_polar(&physical->acceleration, 7.5f,
-                                 physical->angle);
+            rr_vector_from_polar(rr_simulation_get_acceleration(simulation, id),
+                                 7.5f, physical->angle);
         else if (petal->id == rr_petal_id_seed)
         {
             if (!rr_simulation_entity_alive(simulation, petal->bind_target) ||
@@ -1012,7 +1034,8 @@ static void system_petal_misc_logic(EntityIdx id, void *_simulation)
                                       target_physical->y - physical->y};
             rr_vector_add(&delta, &petal->bind_pos);
             rr_vector_scale(&delta, 0.4);
-            rr_vector_add(&physical->acceleration, &delta);
+            rr_vector_add(rr_simulation_get_acceleration(simulation, id),
+                          &delta);
             struct rr_component_relations *target_relations =
                 rr_simulation_get_relations(simulation, petal->bind_target);
             struct rr_component_player_info *target_player_info =
@@ -1054,7 +1077,7 @@ static void system_petal_misc_logic(EntityIdx id, void *_simulation)
                 rr_component_physical_set_y(nest_physical, physical->y);
                 rr_component_physical_set_radius(nest_physical, 250);
                 rr_component_physical_set_angle(nest_physical, rr_frand() * 2 * M_PI);
-                nest_physical->friction = 0.75;
+                *rr_simulation_get_friction(simulation, nest_id) = 0.75;
                 nest_physical->arena = physical->arena;
                 struct rr_component_relations *nest_relations =
                     rr_simulation_add_relations(simulation, nest_id);
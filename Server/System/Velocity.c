@@ -197,49 +197,76 @@ static uint32_t min_of_4(float *arr)
     return min;
 }
 
-static void system_velocity(EntityIdx id, void *simulation)
+static void system_acceleration_scale(EntityIdx id, void *simulation)
 {
     struct rr_component_physical *physical =
         rr_simulation_get_physical(simulation, id);
-    rr_vector_scale(&physical->velocity, physical->friction);
-    physical->acceleration_scale *=
+    float *acceleration_scale =
+        rr_simulation_get_acceleration_scale(simulation, id);
+    *acceleration_scale *=
         rr_lerp(physical->web_slowdown, 1, physical->slow_resist);
     if (physical->stun_ticks > 0)
     {
         if (!rr_simulation_has_petal(simulation, id))
-            physical->acceleration_scale = 0;
+            *acceleration_scale = 0;
         --physical->stun_ticks;
     }
-    struct rr_vector accel = {
-        physical->acceleration.x * physical->acceleration_scale,
-        physical->acceleration.y * physical->acceleration_scale};
-    rr_vector_add(&physical->velocity, &accel);
+}
+
+// velocity = velocity * friction + acceleration * acceleration_scale for every
+// slot up to the last physical entity. Slots without physical are at rest so
+// they can go through the same loop instead of being skipped
+static void integrate_velocity(struct rr_simulation *this)
+{
+    struct rr_simulation_motion *motion = &this->motion;
+    uint32_t end = 0;
+    for (EntityIdx i = 0; i < this->physical_count; ++i)
+        if (this->physical_vector[i] >= end)
+            end = this->physical_vector[i] + 1;
+    for (uint32_t i = 0; i < end; ++i)
+    {
+        float friction = motion->friction[i];
+        float scale = motion->acceleration_scale[i];
+        motion->velocity[i].x = motion->velocity[i].x * friction +
+                                motion->acceleration[i].x * scale;
+        motion->velocity[i].y = motion->velocity[i].y * friction +
+                                motion->acceleration[i].y * scale;
+    }
+}
+
+static void system_velocity(EntityIdx id, void *simulation)
+{
+    struct rr_component_physical *physical =
+        rr_simulation_get_physical(simulation, id);
+    struct rr_vector *velocity = rr_simulation_get_velocity(simulation, id);
+    struct rr_vector *acceleration =
+        rr_simulation_get_acceleration(simulation, id);
     if (physical->bubbling)
     {
-        float vel = rr_vector_get_magnitude(&physical->velocity);
+        float vel = rr_vector_get_magnitude(velocity);
         if (physical->wall_collision.x || physical->wall_collision.y)
         {
             float angle = 2 * rr_vector_theta(&physical->wall_collision) -
-                              (M_PI + rr_vector_theta(&physical->velocity));
-            rr_vector_from_polar(&physical->velocity, vel, angle);
+                              (M_PI + rr_vector_theta(velocity));
+            rr_vector_from_polar(velocity, vel, angle);
         }
         if (vel < 25)
             physical->bubbling = 0;
     }
-    physical->acceleration_scale = physical->web_slowdown = 1;
-    struct rr_vector vel = {physical->velocity.x, physical->velocity.y};
-    rr_vector_add(&vel, &physical->collision_velocity);
+    *rr_simulation_get_acceleration_scale(simulation, id) =
+        physical->web_slowdown = 1;
+    struct rr_vector vel = {velocity->x, velocity->y};
+    rr_vector_add(&vel, rr_simulation_get_collision_velocity(simulation, id));
     if (rr_simulation_has_flower(simulation, id))
     {
-        if (physical->acceleration.x != 0.0f ||
-            physical->acceleration.y != 0.0f)
+        if (acceleration->x != 0.0f || acceleration->y != 0.0f)
         {
             rr_component_flower_set_eye_angle(
                 rr_simulation_get_flower(simulation, id),
-                rr_vector_theta(&physical->acceleration));
+                rr_vector_theta(acceleration));
         }
     }
-    rr_vector_set(&physical->acceleration, 0, 0);
+    rr_vector_set(acceleration, 0, 0);
     rr_vector_set(&physical->wall_collision, 0, 0);
     struct rr_component_arena *arena =
         rr_simulation_get_arena(simulation, physical->arena);
@@ -261,7 +288,7 @@ static void system_velocity(EntityIdx id, void *simulation)
     {
         rr_component_flower_set_dead(
             rr_simulation_get_flower(simulation, id), simulation, 1);
-        physical->friction = 0.75;
+        *rr_simulation_get_friction(simulation, id) = 0.75;
     }
 
     if (rr_simulation_has_web(simulation, id) ||
@@ -382,5 +409,8 @@ static void system_velocity(EntityIdx id, void *simulation)
 
 void rr_system_velocity_tick(struct rr_simulation *simulation)
 {
+    rr_simulation_for_each_physical(simulation, simulation,
+                                    system_acceleration_scale);
+    integrate_velocity(simulation);
     rr_simulation_for_each_physical(simulation, simulation, system_velocity);
 }
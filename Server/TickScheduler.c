@@ -0,0 +1,120 @@
+// Copyright (C) 2024 Paul Johnson
+// Copyright (C) 2024-2025 Maxim Nesterov
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <Server/TickScheduler.h>
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#define NSEC_PER_SEC (1000000000ull)
+
+static uint64_t timespec_to_ns(struct timespec *t)
+{
+    return t->tv_sec * NSEC_PER_SEC + t->tv_nsec;
+}
+
+static struct timespec ns_to_timespec(uint64_t ns)
+{
+    return (struct timespec){ns / NSEC_PER_SEC, ns % NSEC_PER_SEC};
+}
+
+static uint64_t now_ns()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return timespec_to_ns(&now);
+}
+
+void rr_tick_scheduler_init(struct rr_tick_scheduler *this, uint32_t tick_rate,
+                            uint32_t max_catch_up_ticks)
+{
+    memset(this, 0, sizeof *this);
+    this->period = NSEC_PER_SEC / tick_rate;
+    this->max_catch_up_ticks = max_catch_up_ticks;
+    this->report_interval = 60 * tick_rate;
+    this->deadline = ns_to_timespec(now_ns());
+}
+
+void rr_tick_scheduler_begin_tick(struct rr_tick_scheduler *this)
+{
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &this->deadline,
+                           NULL) == EINTR)
+        ;
+    clock_gettime(CLOCK_MONOTONIC, &this->tick_start);
+    uint64_t lateness =
+        (timespec_to_ns(&this->tick_start) - timespec_to_ns(&this->deadline)) /
+        1000;
+    uint32_t bucket = 0;
+    while (bucket < RR_TICK_LATENESS_BUCKET_COUNT - 1 &&
+           lateness >= (2ull << bucket))
+        ++bucket;
+    ++this->lateness_buckets[bucket];
+    if (lateness > this->max_lateness)
+        this->max_lateness = lateness;
+    ++this->tick_count;
+}
+
+uint64_t rr_tick_scheduler_lateness_percentile(struct rr_tick_scheduler *this,
+                                               uint32_t percentile)
+{
+    uint64_t target = (this->tick_count * percentile + 99) / 100;
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < RR_TICK_LATENESS_BUCKET_COUNT; ++i)
+    {
+        seen += this->lateness_buckets[i];
+        if (seen >= target)
+            return 2ull << i;
+    }
+    return this->max_lateness;
+}
+
+void rr_tick_scheduler_end_tick(struct rr_tick_scheduler *this)
+{
+    uint64_t now = now_ns();
+    uint64_t elapsed = (now - timespec_to_ns(&this->tick_start)) / 1000;
+    if (elapsed > this->period / 1000 * 5 / 8)
+        fprintf(stderr, "tick took %lu microseconds\n", elapsed);
+
+    uint64_t deadline = timespec_to_ns(&this->deadline) + this->period;
+    if (now > deadline)
+    {
+        ++this->overrun_count;
+        uint64_t behind = (now - deadline) / this->period;
+        if (behind > this->max_catch_up_ticks)
+        {
+            // too far behind to pay it back, start over from now
+            this->skipped_tick_count += behind;
+            deadline = now;
+        }
+    }
+    this->deadline = ns_to_timespec(deadline);
+
+    if (this->tick_count < this->report_interval)
+        return;
+    fprintf(stderr,
+            "tick lateness over %lu ticks: p50 <%luus p99 <%luus max %luus, "
+            "%lu overruns, %lu skipped\n",
+            this->tick_count, rr_tick_scheduler_lateness_percentile(this, 50),
+            rr_tick_scheduler_lateness_percentile(this, 99),
+            this->max_lateness, this->overrun_count,
+            this->skipped_tick_count);
+    memset(this->lateness_buckets, 0, sizeof this->lateness_buckets);
+    this->max_lateness = 0;
+    this->tick_count = 0;
+    this->overrun_count = 0;
+    this->skipped_tick_count = 0;
+}
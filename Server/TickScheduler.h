@@ -0,0 +1,58 @@
+// Copyright (C) 2024 Paul Johnson
+// Copyright (C) 2024-2025 Maxim Nesterov
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <stdint.h>
+#include <time.h>
+
+// Tick counts that stand for real time are written in terms of this. Per
+// tick physics such as friction and speeds are still tuned for 25
+#ifndef RR_SERVER_TICK_RATE
+#define RR_SERVER_TICK_RATE (25)
+#endif
+
+// lateness buckets are powers of two in microseconds, the last one catches
+// everything from about half a second up
+#define RR_TICK_LATENESS_BUCKET_COUNT (20)
+
+struct rr_tick_scheduler
+{
+    struct timespec deadline;
+    struct timespec tick_start;
+    uint64_t period;
+    uint64_t lateness_buckets[RR_TICK_LATENESS_BUCKET_COUNT];
+    uint64_t max_lateness;
+    uint64_t tick_count;
+    uint64_t overrun_count;
+    uint64_t skipped_tick_count;
+    uint32_t max_catch_up_ticks;
+    uint32_t report_interval;
+};
+
+// Tick rate is in hz. A late tick is paid back by running the following
+// ones back to back, but never more than max_catch_up_ticks of them. Past
+// that the missed ticks are dropped and the schedule restarts from now
+void rr_tick_scheduler_init(struct rr_tick_scheduler *, uint32_t, uint32_t);
+// Blocks until the next deadline and records how late the tick started
+void rr_tick_scheduler_begin_tick(struct rr_tick_scheduler *);
+// Advances the deadline and prints the lateness distribution every
+// report_interval ticks
+void rr_tick_scheduler_end_tick(struct rr_tick_scheduler *);
+// Upper bound in microseconds of the given percentile (0 to 100) of tick
+// lateness since the last report
+uint64_t rr_tick_scheduler_lateness_percentile(struct rr_tick_scheduler *,
+                                               uint32_t);
@@ -18,6 +18,7 @@
 
 #include <assert.h>
 #include <inttypes.h>
+#include <math.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -36,31 +37,68 @@ struct rr_protocol_for_each_function_captures
     struct rr_simulation *simulation;
     struct proto_bug *encoder;
     struct rr_component_player_info *player_info;
-    uint8_t *entities_in_view;
+    uint8_t *entered_view;
+    uint8_t *stale;
+    struct rr_update_cache *cache;
+    // update rate lod, see rr_simulation_write_binary
+    uint8_t *priority;
+    uint8_t *always;
+    uint8_t *due;
+    uint8_t *overdue;
+    uint8_t *sent;
+    uint8_t *budget_end;
+    float view_x;
+    float view_y;
+    float view_width;
+    float view_height;
 };
 
-static void rr_simulation_write_entity_function(uint64_t _id, void *_captures)
-{
-    EntityIdx id = _id;
-    struct rr_protocol_for_each_function_captures *captures = _captures;
-    struct rr_simulation *simulation = captures->simulation;
-    struct proto_bug *encoder = captures->encoder;
-    struct rr_component_player_info *player_info = captures->player_info;
-    uint8_t *new_entities_in_view = captures->entities_in_view;
-
-    proto_bug_write_varuint(encoder, id, "entity update id");
+// The shapes entities get created with. Components have to be listed in
+// RR_FOR_EACH_COMPONENT order since that's the order the client reads them in.
+// Anything not listed goes through the generic writer
+#define RR_FOR_EACH_ARCHETYPE                                                  \
+    ARCHETYPE(flower, C(flower) C(health) C(relations) C(physical))            \
+    ARCHETYPE(petal, C(health) C(relations) C(physical) C(petal))              \
+    ARCHETYPE(mob, C(ai) C(mob) C(health) C(relations) C(physical))            \
+    ARCHETYPE(centipede,                                                       \
+              C(ai) C(centipede) C(mob) C(health) C(relations) C(physical))    \
+    ARCHETYPE(hive, C(ai) C(mob) C(arena) C(relations) C(physical))            \
+    ARCHETYPE(drop, C(relations) C(physical) C(drop))                          \
+    ARCHETYPE(web, C(web) C(relations) C(physical))                            \
+    ARCHETYPE(nest, C(health) C(relations) C(physical) C(nest))                \
+    ARCHETYPE(arena, C(arena))                                                 \
+    ARCHETYPE(player_info, C(player_info))
 
-    uint8_t is_creation = 0;
+// entity_tracker value of each archetype, bit 0 is the entity itself
+enum rr_archetype_signature
+{
+#define C(COMPONENT) | rr_component_mask_##COMPONENT
+#define ARCHETYPE(NAME, COMPONENTS) rr_archetype_signature_##NAME = 1 COMPONENTS,
+    RR_FOR_EACH_ARCHETYPE
+#undef ARCHETYPE
+#undef C
+};
 
-    if (!rr_bitset_get_bit(player_info->entities_in_view, id))
-    {
-        is_creation = 1;
-        rr_bitset_set(player_info->entities_in_view, id);
+#define C(COMPONENT)                                                           \
+    rr_component_##COMPONENT##_write(                                          \
+        rr_simulation_get_##COMPONENT(simulation, id), encoder, is_creation,   \
+        player_info);
+#define ARCHETYPE(NAME, COMPONENTS)                                            \
+    static void write_##NAME(struct rr_simulation *simulation, EntityIdx id,   \
+                             struct proto_bug *encoder, uint8_t is_creation,   \
+                             struct rr_component_player_info *player_info)     \
+    {                                                                          \
+        COMPONENTS                                                             \
     }
+RR_FOR_EACH_ARCHETYPE
+#undef ARCHETYPE
+#undef C
 
+static void write_any(struct rr_simulation *simulation, EntityIdx id,
+                      struct proto_bug *encoder, uint8_t is_creation,
+                      struct rr_component_player_info *player_info)
+{
     uint32_t component_flags = simulation->entity_tracker[id];
-    proto_bug_write_uint8(encoder, is_creation, "upcreate");
-    proto_bug_write_varuint(encoder, component_flags, "entity component flags");
 #define XX(COMPONENT, ID)                                                      \
     if (component_flags & (1 << ID))                                           \
         rr_component_##COMPONENT##_write(                                      \
@@ -70,6 +108,173 @@ static void rr_simulation_write_entity_function(uint64_t _id, void *_captures)
 #undef XX
 }
 
+void rr_update_cache_begin_tick(struct rr_update_cache *this,
+                                struct rr_simulation *simulation)
+{
+    memset(this->dirty, 0, sizeof this->dirty);
+#define XX(COMPONENT, ID)                                                      \
+    for (EntityIdx i = 0; i < simulation->COMPONENT##_count; ++i)              \
+    {                                                                          \
+        EntityIdx entity = simulation->COMPONENT##_vector[i];                  \
+        if (rr_simulation_get_##COMPONENT(simulation, entity)->protocol_state) \
+            rr_bitset_set(this->dirty, entity);                                \
+    }
+    RR_FOR_EACH_COMPONENT;
+#undef XX
+
+    if (this->arena == NULL)
+        this->arena = malloc(RR_UPDATE_CACHE_ARENA_SIZE);
+    this->arena_used = 0;
+    // 0 is never a valid tick so the zeroed entries start out empty
+    if (++this->tick == 0)
+    {
+        memset(this->claimed, 0, sizeof this->claimed);
+        memset(this->ready, 0, sizeof this->ready);
+        this->tick = 1;
+    }
+}
+
+static void write_entity(struct rr_simulation *simulation,
+                         struct proto_bug *encoder, EntityIdx id,
+                         uint8_t is_creation,
+                         struct rr_component_player_info *player_info)
+{
+    uint32_t component_flags = simulation->entity_tracker[id];
+    proto_bug_write_varuint(encoder, component_flags, "entity component flags");
+    switch (component_flags)
+    {
+#define ARCHETYPE(NAME, COMPONENTS)                                            \
+    case rr_archetype_signature_##NAME:                                        \
+        write_##NAME(simulation, id, encoder, is_creation, player_info);       \
+        break;
+        RR_FOR_EACH_ARCHETYPE
+#undef ARCHETYPE
+    default:
+        write_any(simulation, id, encoder, is_creation, player_info);
+    }
+}
+
+static void rr_simulation_write_entity_function(uint64_t _id, void *_captures)
+{
+    EntityIdx id = _id;
+    struct rr_protocol_for_each_function_captures *captures = _captures;
+    struct rr_simulation *simulation = captures->simulation;
+    struct proto_bug *encoder = captures->encoder;
+    struct rr_update_cache *cache = captures->cache;
+    // 1 = new to the client, 2 = the client missed updates to it and gets
+    // its full state without recreating it
+    uint8_t upcreate = rr_bitset_get(captures->entered_view, id)
+                           ? 1
+                           : rr_bitset_get(captures->stale, id) ? 2 : 0;
+    uint8_t is_creation = upcreate != 0;
+    proto_bug_write_varuint(encoder, id, "entity update id");
+    proto_bug_write_uint8(encoder, upcreate, "upcreate");
+
+    // player_info masks fields by viewer
+    if (simulation->entity_tracker[id] & rr_component_mask_player_info)
+    {
+        write_entity(simulation, encoder, id, is_creation,
+                     captures->player_info);
+        return;
+    }
+    if (__atomic_load_n(&cache->ready[is_creation][id], __ATOMIC_ACQUIRE) ==
+        cache->tick)
+    {
+        proto_bug_write_bytes(encoder,
+                              cache->arena + cache->offsets[is_creation][id],
+                              cache->sizes[is_creation][id]);
+        return;
+    }
+
+    uint8_t *start = encoder->current;
+    write_entity(simulation, encoder, id, is_creation, captures->player_info);
+    // a cut off copy can't be shared, this client gets kicked anyway
+    if (encoder->overflowed)
+        return;
+    // whoever claims the entry first publishes it, everyone else that got
+    // here before it was ready just keeps their own copy
+    if (__atomic_exchange_n(&cache->claimed[is_creation][id], cache->tick,
+                            __ATOMIC_RELAXED) == cache->tick)
+        return;
+    uint32_t size = encoder->current - start;
+    uint64_t offset =
+        __atomic_fetch_add(&cache->arena_used, size, __ATOMIC_RELAXED);
+    if (offset + size > RR_UPDATE_CACHE_ARENA_SIZE)
+        return;
+    memcpy(cache->arena + offset, start, size);
+    cache->offsets[is_creation][id] = offset;
+    cache->sizes[is_creation][id] = size;
+    __atomic_store_n(&cache->ready[is_creation][id], cache->tick,
+                     __ATOMIC_RELEASE);
+}
+
+// how much an entity's update priority goes up per tick, it gets sent once
+// it reaches RR_UPDATE_LOD_DUE. 0 means send every tick regardless of budget
+static uint32_t
+lod_priority_increment(struct rr_protocol_for_each_function_captures *captures,
+                       EntityIdx id)
+{
+    struct rr_simulation *simulation = captures->simulation;
+    if (!rr_simulation_has_physical(simulation, id) ||
+        rr_simulation_has_player_info(simulation, id))
+        return 0;
+    struct rr_component_physical *physical =
+        rr_simulation_get_physical(simulation, id);
+    float distance =
+        fmaxf(fabsf(physical->x - captures->view_x) / captures->view_width,
+              fabsf(physical->y - captures->view_y) / captures->view_height);
+    if (distance < RR_UPDATE_LOD_NEAR)
+        return 0;
+    float period = 1 + (distance - RR_UPDATE_LOD_NEAR) /
+                           (1 - RR_UPDATE_LOD_NEAR) *
+                           (RR_UPDATE_LOD_MAX_PERIOD - 1);
+    if (period > RR_UPDATE_LOD_MAX_PERIOD)
+        period = RR_UPDATE_LOD_MAX_PERIOD;
+    // fast movers drift further from the client's guess between updates
+    struct rr_vector *velocity = rr_simulation_get_velocity(simulation, id);
+    period /= 1 + sqrtf(velocity->x * velocity->x + velocity->y * velocity->y) /
+                      RR_UPDATE_LOD_SPEED;
+    if (period <= 1)
+        return RR_UPDATE_LOD_DUE;
+    return (uint32_t)(RR_UPDATE_LOD_DUE / period) + 1;
+}
+
+static void rr_simulation_prioritize_entity_function(uint64_t _id,
+                                                     void *_captures)
+{
+    EntityIdx id = _id;
+    struct rr_protocol_for_each_function_captures *captures = _captures;
+    uint32_t increment = lod_priority_increment(captures, id);
+    if (increment == 0)
+    {
+        rr_bitset_set(captures->always, id);
+        return;
+    }
+    uint32_t priority = captures->priority[id] + increment;
+    captures->priority[id] = priority > 255 ? 255 : priority;
+    if (priority >= 255)
+        rr_bitset_set(captures->overdue, id);
+    else if (priority >= RR_UPDATE_LOD_DUE)
+        rr_bitset_set(captures->due, id);
+}
+
+static void rr_simulation_send_entity_function(uint64_t _id, void *_captures)
+{
+    EntityIdx id = _id;
+    struct rr_protocol_for_each_function_captures *captures = _captures;
+    rr_simulation_write_entity_function(id, captures);
+    rr_bitset_set(captures->sent, id);
+    captures->priority[id] = 0;
+}
+
+static void rr_simulation_send_budgeted_entity_function(uint64_t id,
+                                                        void *_captures)
+{
+    struct rr_protocol_for_each_function_captures *captures = _captures;
+    if (captures->encoder->current < captures->budget_end)
+        rr_simulation_send_entity_function(id, captures);
+}
+
 struct rr_simulation_find_entities_in_view_for_each_function_captures
 {
     int32_t view_width;
@@ -141,47 +346,60 @@ static void rr_simulation_find_entities_in_view(
     rr_bitset_set(captures.entities_in_view, 1);
     struct rr_spatial_hash *shg =
         &rr_simulation_get_arena(this, player_info->arena)->spatial_hash;
-    rr_spatial_hash_query(
+    struct rr_spatial_hash_filter filter = {rr_component_mask_any, 0, 0,
+                                            rr_spatial_hash_team_any};
+    rr_spatial_hash_query_box(
         shg, captures.view_x, captures.view_y, captures.view_width,
-        captures.view_height, &captures,
+        captures.view_height, &filter, &captures,
         rr_simulation_find_entities_in_view_for_each_function);
 }
 
+static uint8_t deletion_type(struct rr_simulation *simulation,
+                             struct rr_component_player_info *player_info,
+                             EntityIdx id)
+{
+    uint8_t serverside_delete = !entity_alive(simulation, id);
+    if (serverside_delete == 0)
+    {
+        if (rr_simulation_has_drop(simulation, id))
+        {
+            struct rr_component_drop *drop =
+                rr_simulation_get_drop(simulation, id);
+            if (drop->can_be_picked_up_by != player_info->squad)
+                serverside_delete = 1;
+            else if (drop->picked_up_by & (1 << player_info->squad_pos))
+                // 1 = in-place deletion, 2 = suck to player
+                serverside_delete = 2;
+        }
+    }
+    return serverside_delete;
+}
+
 static void rr_simulation_write_entity_deletions_function(uint64_t _id,
                                                           void *_captures)
 {
     EntityIdx id = _id;
     struct rr_protocol_for_each_function_captures *captures = _captures;
     struct rr_component_player_info *player_info = captures->player_info;
+    struct rr_server_client *client = player_info->client;
     struct proto_bug *encoder = captures->encoder;
-    uint8_t *new_entities_in_view = captures->entities_in_view;
 
-    if (!rr_bitset_get_bit(new_entities_in_view, id))
-    {
-        // deletion spotted!
-        uint8_t serverside_delete = !entity_alive(captures->simulation, id);
-        if (serverside_delete == 0)
-        {
-            if (rr_simulation_has_drop(captures->simulation, id))
-            {
-                struct rr_component_drop *drop =
-                    rr_simulation_get_drop(captures->simulation, id);
-                if (drop->can_be_picked_up_by != player_info->squad)
-                    serverside_delete = 1;
-                else if (drop->picked_up_by & (1 << player_info->squad_pos))
-                    // 1 = in-place deletion, 2 = suck to player
-                    serverside_delete = 2;
-            }
-        }
-        rr_bitset_unset(player_info->entities_in_view, id);
-        proto_bug_write_varuint(encoder, id, "entity deletion id");
-        proto_bug_write_uint8(encoder, serverside_delete, "deletion type");
-    }
+    // deletion spotted! ones from while the client was held back were
+    // decided back then, the id may belong to something else by now
+    uint8_t serverside_delete =
+        rr_bitset_get(client->update_deleted, id)
+            ? client->update_deletion_type[id]
+            : deletion_type(captures->simulation, player_info, id);
+    proto_bug_write_varuint(encoder, id, "entity deletion id");
+    proto_bug_write_uint8(encoder, serverside_delete, "deletion type");
+    // whatever reuses the id starts waiting from scratch
+    captures->priority[id] = 0;
 }
 
 void rr_simulation_write_binary(struct rr_simulation *this,
                                 struct proto_bug *encoder,
-                                struct rr_component_player_info *player_info)
+                                struct rr_component_player_info *player_info,
+                                struct rr_update_cache *cache)
 {
     uint8_t new_entities_in_view[RR_BITSET_ROUND(RR_MAX_ENTITY_COUNT)] = {0};
 
@@ -203,29 +421,108 @@ void rr_simulation_write_binary(struct rr_simulation *this,
             rr_bitset_set(new_entities_in_view, (EntityIdx)p_info->flower_id);
     }
 
+    // left and entered view in a few word operations instead of testing the
+    // old view bit by bit
+    uint64_t const size = RR_BITSET_ROUND(RR_MAX_ENTITY_COUNT);
+    uint8_t left_view[RR_BITSET_ROUND(RR_MAX_ENTITY_COUNT)];
+    uint8_t entered_view[RR_BITSET_ROUND(RR_MAX_ENTITY_COUNT)];
+    rr_bitset_andnot(left_view, player_info->entities_in_view,
+                     new_entities_in_view, size);
+    rr_bitset_andnot(entered_view, new_entities_in_view,
+                     player_info->entities_in_view, size);
+    memcpy(player_info->entities_in_view, new_entities_in_view, size);
+    // entities that didn't change and aren't new to this client are skipped,
+    // the client keeps whatever it last got for them. ones it missed an
+    // update to stay candidates until they go out
+    struct rr_server_client *client = player_info->client;
+    uint8_t candidates[RR_BITSET_ROUND(RR_MAX_ENTITY_COUNT)];
+    rr_bitset_and(candidates, new_entities_in_view, cache->dirty, size);
+    rr_bitset_or(candidates, candidates, client->update_stale, size);
+    rr_bitset_and(candidates, candidates, new_entities_in_view, size);
+    rr_bitset_andnot(candidates, candidates, entered_view, size);
+
+    uint8_t always[RR_BITSET_ROUND(RR_MAX_ENTITY_COUNT)] = {0};
+    uint8_t due[RR_BITSET_ROUND(RR_MAX_ENTITY_COUNT)] = {0};
+    uint8_t overdue[RR_BITSET_ROUND(RR_MAX_ENTITY_COUNT)] = {0};
+    uint8_t sent[RR_BITSET_ROUND(RR_MAX_ENTITY_COUNT)] = {0};
+
     struct rr_protocol_for_each_function_captures captures;
     captures.simulation = this;
     captures.encoder = encoder;
     captures.player_info = player_info;
-    captures.entities_in_view = new_entities_in_view;
+    captures.entered_view = entered_view;
+    captures.stale = client->update_stale;
+    captures.cache = cache;
+    captures.priority = client->update_priority;
+    captures.always = always;
+    captures.due = due;
+    captures.overdue = overdue;
+    captures.sent = sent;
+    captures.view_x = player_info->camera_x;
+    captures.view_y = player_info->camera_y;
+    captures.view_width = 1280.0f / player_info->camera_fov;
+    captures.view_height = 720.0f / player_info->camera_fov;
 
-    rr_bitset_for_each_bit(&player_info->entities_in_view[0],
-                           &player_info->entities_in_view[0] +
-                               (RR_BITSET_ROUND(RR_MAX_ENTITY_COUNT)),
-                           &captures,
+    rr_bitset_or(left_view, left_view, client->update_deleted, size);
+    rr_bitset_for_each_bit(left_view, left_view + size, &captures,
                            rr_simulation_write_entity_deletions_function);
+    memset(client->update_deleted, 0, size);
     proto_bug_write_varuint(
         encoder, RR_NULL_ENTITY,
         "entity deletion id"); // null terminate deletion list
 
-    rr_bitset_for_each_bit(new_entities_in_view,
-                           new_entities_in_view +
-                               (RR_BITSET_ROUND(RR_MAX_ENTITY_COUNT)),
-                           &captures, rr_simulation_write_entity_function);
+    // new and nearby entities always go out. far ones build up priority
+    // depending on distance and speed and go out once due, longest waiting
+    // first, until the byte budget runs out
+    rr_bitset_for_each_bit(candidates, candidates + size, &captures,
+                           rr_simulation_prioritize_entity_function);
+    rr_bitset_or(always, always, entered_view, size);
+    captures.budget_end = encoder->current + RR_UPDATE_BYTE_BUDGET;
+    rr_bitset_for_each_bit(always, always + size, &captures,
+                           rr_simulation_send_entity_function);
+    rr_bitset_for_each_bit(overdue, overdue + size, &captures,
+                           rr_simulation_send_budgeted_entity_function);
+    rr_bitset_for_each_bit(due, due + size, &captures,
+                           rr_simulation_send_budgeted_entity_function);
+    rr_bitset_andnot(client->update_stale, candidates, sent, size);
     proto_bug_write_varuint(encoder, RR_NULL_ENTITY,
                             "entity update id"); // null terminate update list
     proto_bug_write_varuint(encoder, player_info->parent_id,
                             "pinfo id"); // send client's pinfo
     proto_bug_write_uint8(encoder, this->game_over, "game over");
 }
+
+static void rr_simulation_skip_entity_function(uint64_t id, void *_captures)
+{
+    struct rr_protocol_for_each_function_captures *captures = _captures;
+    if (entity_alive(captures->simulation, id))
+        return;
+    struct rr_server_client *client = captures->player_info->client;
+    rr_bitset_set(client->update_deleted, id);
+    client->update_deletion_type[id] =
+        deletion_type(captures->simulation, captures->player_info, id);
+}
+
+void rr_simulation_skip_binary(struct rr_simulation *this,
+                               struct rr_component_player_info *player_info,
+                               struct rr_update_cache *cache)
+{
+    // whatever changed counts as missed. dead entities come out of the view
+    // right away so their ids can't be mistaken for whatever reuses them
+    struct rr_server_client *client = player_info->client;
+    uint64_t const size = RR_BITSET_ROUND(RR_MAX_ENTITY_COUNT);
+    uint8_t changed[RR_BITSET_ROUND(RR_MAX_ENTITY_COUNT)];
+    rr_bitset_and(changed, player_info->entities_in_view, cache->dirty, size);
+    rr_bitset_or(client->update_stale, client->update_stale, changed, size);
+
+    struct rr_protocol_for_each_function_captures captures;
+    captures.simulation = this;
+    captures.player_info = player_info;
+    rr_bitset_for_each_bit(player_info->entities_in_view,
+                           player_info->entities_in_view + size, &captures,
+                           rr_simulation_skip_entity_function);
+    rr_bitset_andnot(player_info->entities_in_view,
+                     player_info->entities_in_view, client->update_deleted,
+                     size);
+}
 #undef entity_alive
\ No newline at end of file
@@ -16,9 +16,55 @@
 
 #pragma once
 
+#include <stdint.h>
+
+#include <Shared/Bitset.h>
+#include <Shared/Entity.h>
+
 struct rr_simulation;
 struct proto_bug;
 struct rr_component_player_info;
 
+#define RR_UPDATE_CACHE_ARENA_SIZE (8 * 1024 * 1024)
+
+// entities within RR_UPDATE_LOD_NEAR of the camera (as a fraction of the view
+// box) are updated every tick. further out they're updated every few ticks,
+// up to RR_UPDATE_LOD_MAX_PERIOD at the edge, and RR_UPDATE_LOD_SPEED faster
+// halves that. far updates are cut off once a client's update list reaches
+// RR_UPDATE_BYTE_BUDGET bytes
+#define RR_UPDATE_LOD_NEAR (0.5f)
+#define RR_UPDATE_LOD_MAX_PERIOD (4)
+#define RR_UPDATE_LOD_SPEED (10.0f)
+#define RR_UPDATE_LOD_DUE (128)
+#define RR_UPDATE_BYTE_BUDGET (8 * 1024)
+
+// Entity updates only depend on the viewer through player_info, so everything
+// else gets encoded by the first client that sees it each tick and memcpy'd by
+// the rest. Index 0 is the delta, index 1 the full creation encoding. Filled
+// concurrently by the encode jobs, an entry is valid once ready == tick
+struct rr_update_cache
+{
+    uint8_t *arena;
+    uint64_t arena_used;
+    uint32_t tick;
+    // entities with a component whose protocol_state is set this tick, the
+    // only ones besides new entities that go in a client's update list
+    uint8_t dirty[RR_BITSET_ROUND(RR_MAX_ENTITY_COUNT)];
+    uint32_t claimed[2][RR_MAX_ENTITY_COUNT];
+    uint32_t ready[2][RR_MAX_ENTITY_COUNT];
+    uint32_t offsets[2][RR_MAX_ENTITY_COUNT];
+    uint32_t sizes[2][RR_MAX_ENTITY_COUNT];
+};
+
+// call once per tick before encoding starts
+void rr_update_cache_begin_tick(struct rr_update_cache *,
+                                struct rr_simulation *);
+
 void rr_simulation_write_binary(struct rr_simulation *, struct proto_bug *,
-                                struct rr_component_player_info *);
+                                struct rr_component_player_info *,
+                                struct rr_update_cache *);
+// For a client that is behind on frames. Remembers what changed in its view
+// this tick so the next rr_simulation_write_binary catches it up
+void rr_simulation_skip_binary(struct rr_simulation *,
+                               struct rr_component_player_info *,
+                               struct rr_update_cache *);
@@ -0,0 +1,91 @@
+// Copyright (C) 2024 Paul Johnson
+// Copyright (C) 2024-2025 Maxim Nesterov
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <Server/WorkerPool.h>
+
+#include <string.h>
+
+static void worker_pool_drain(struct rr_worker_pool *this)
+{
+    uint32_t i;
+    while ((i = __atomic_fetch_add(&this->next_job, 1, __ATOMIC_RELAXED)) <
+           this->job_count)
+        this->job(i, this->captures);
+}
+
+static void *worker_pool_thread(void *_this)
+{
+    struct rr_worker_pool *this = _this;
+    uint32_t generation = 0;
+    pthread_mutex_lock(&this->mutex);
+    while (1)
+    {
+        while (this->generation == generation)
+            pthread_cond_wait(&this->work_ready, &this->mutex);
+        generation = this->generation;
+        pthread_mutex_unlock(&this->mutex);
+        worker_pool_drain(this);
+        pthread_mutex_lock(&this->mutex);
+        if (--this->busy_count == 0)
+            pthread_cond_signal(&this->work_done);
+    }
+    return NULL;
+}
+
+void rr_worker_pool_init(struct rr_worker_pool *this, uint32_t thread_count)
+{
+    memset(this, 0, sizeof *this);
+    if (thread_count > RR_WORKER_POOL_MAX_THREAD_COUNT)
+        thread_count = RR_WORKER_POOL_MAX_THREAD_COUNT;
+    pthread_mutex_init(&this->mutex, NULL);
+    pthread_cond_init(&this->work_ready, NULL);
+    pthread_cond_init(&this->work_done, NULL);
+    for (uint32_t i = 0; i < thread_count; ++i)
+    {
+        if (pthread_create(&this->threads[i], NULL, worker_pool_thread, this))
+            break;
+        pthread_detach(this->threads[i]);
+        ++this->thread_count;
+    }
+}
+
+void rr_worker_pool_run(struct rr_worker_pool *this, uint32_t job_count,
+                        void *captures, void (*job)(uint32_t, void *))
+{
+    if (this->thread_count == 0 || job_count < 2)
+    {
+        for (uint32_t i = 0; i < job_count; ++i)
+            job(i, captures);
+        return;
+    }
+    pthread_mutex_lock(&this->mutex);
+    this->job = job;
+    this->captures = captures;
+    this->job_count = job_count;
+    this->next_job = 0;
+    this->busy_count = this->thread_count;
+    ++this->generation;
+    pthread_cond_broadcast(&this->work_ready);
+    pthread_mutex_unlock(&this->mutex);
+
+    // the calling thread takes jobs too instead of idling on the condition
+    worker_pool_drain(this);
+
+    pthread_mutex_lock(&this->mutex);
+    while (this->busy_count > 0)
+        pthread_cond_wait(&this->work_done, &this->mutex);
+    pthread_mutex_unlock(&this->mutex);
+}
@@ -0,0 +1,46 @@
+// Copyright (C) 2024 Paul Johnson
+// Copyright (C) 2024-2025 Maxim Nesterov
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <pthread.h>
+#include <stdint.h>
+
+#define RR_WORKER_POOL_MAX_THREAD_COUNT (15)
+
+// Fixed set of threads that split an indexed batch of jobs with the caller.
+// Jobs must not touch state shared with other jobs of the same batch.
+struct rr_worker_pool
+{
+    pthread_t threads[RR_WORKER_POOL_MAX_THREAD_COUNT];
+    pthread_mutex_t mutex;
+    pthread_cond_t work_ready;
+    pthread_cond_t work_done;
+    void *captures;
+    void (*job)(uint32_t, void *);
+    uint32_t job_count;
+    uint32_t next_job;
+    uint32_t busy_count;
+    uint32_t generation;
+    uint32_t thread_count;
+};
+
+void rr_worker_pool_init(struct rr_worker_pool *, uint32_t);
+
+// Blocking. Calls the job once for every index below the count and returns
+// when all of them have finished.
+void rr_worker_pool_run(struct rr_worker_pool *, uint32_t, void *,
+                        void (*)(uint32_t, void *));
@@ -16,6 +16,8 @@
 
 #include <Shared/Bitset.h>
 
+#include <string.h>
+
 uint8_t rr_bitset_get_bit(uint8_t *a, uint64_t i)
 {
     // return a[i];
@@ -49,93 +51,55 @@ void rr_bitset_maybe_set(uint8_t *a, uint64_t i, uint8_t bit)
         rr_bitset_unset(a, i);
 }
 
-// void rr_bitset_for_each_bit(uint8_t *start, uint8_t *end, void *captures,
-//                             void (*cb)(uint64_t, void *))
-// {
-//     uint8_t *const original_start = start;
-//     uint64_t bitmapsize = (end - start) / sizeof(uint64_t);
-
-//     uint64_t bitset;
-//     for (uint64_t k = 0; k < bitmapsize; ++k)
-//     {
-//         bitset = bitmap[k];
-//         uint64_t p = k * 64;
-//         while (bitset != 0)
-//         {
-//             if (bitset & 0x1)
-//             {
-//                 cb(p, captures);
-//             }
-//             bitset >>= 1;
-//             p += 1;
-//         }
-//     }
-// }
-
-// void rr_bitset_for_each_bit(uint8_t *start, uint8_t *end, void *captures,
-// void (*cb)(uint64_t, void *))
-// {
-//     uint8_t *const original_start = start;
-
-//     while (start != end)
-//     {
-//         if ((start + 8 < end) && (uint64_t)start % 8 == 0)
-//         {
-//             uint64_t val = *(uint64_t *)start;
-//             while (val)
-//             {
-//                 uint64_t t = __builtin_ctzll(val);
-//                 cb(((start - original_start) << 3) | t, captures);
-//                 val &= val - 1; // clear the rightmost set bit
-//             }
-//             start += 8;
-//         }
-//         else
-//         {
-//             uint8_t val = *start;
-//             while (val)
-//             {
-//                 uint8_t t = __builtin_ctz(val);
-//                 cb(((start - original_start) << 3) | t, captures);
-//                 val &= val - 1; // clear the rightmost set bit
-//             }
-//             start++;
-//         }
-//     }
-// }
+// bitsets are plain byte arrays with no alignment guarantee, memcpy compiles
+// down to a normal load or store
+static uint64_t load_word(uint8_t *a)
+{
+    uint64_t word;
+    memcpy(&word, a, sizeof word);
+    return word;
+}
+
+static void store_word(uint8_t *a, uint64_t word)
+{
+    memcpy(a, &word, sizeof word);
+}
 
 void rr_bitset_for_each_bit(uint8_t *start, uint8_t *end, void *captures,
                             void (*cb)(uint64_t, void *))
 {
-    uint8_t *const original_start = start;
-
-    while (start != end)
-    {
-        if ((start + 8 < end) && (uint64_t)start % 8 == 0 &&
-            !*(uint64_t *)start)
-        {
-            start += 8;
-            continue;
-        }
-        if (*start)
-        {
-            if (*start & 1)
-                cb(((start - original_start) << 3) | 0, captures);
-            if (*start & 2)
-                cb(((start - original_start) << 3) | 1, captures);
-            if (*start & 4)
-                cb(((start - original_start) << 3) | 2, captures);
-            if (*start & 8)
-                cb(((start - original_start) << 3) | 3, captures);
-            if (*start & 16)
-                cb(((start - original_start) << 3) | 4, captures);
-            if (*start & 32)
-                cb(((start - original_start) << 3) | 5, captures);
-            if (*start & 64)
-                cb(((start - original_start) << 3) | 6, captures);
-            if (*start & 128)
-                cb(((start - original_start) << 3) | 7, captures);
-        }
-        start++;
-    }
+    uint64_t size = end - start;
+    uint64_t i = 0;
+    for (; i + 8 <= size; i += 8)
+        for (uint64_t word = load_word(start + i); word; word &= word - 1)
+            cb((i << 3) | __builtin_ctzll(word), captures);
+    for (; i < size; ++i)
+        for (uint32_t byte = start[i]; byte; byte &= byte - 1)
+            cb((i << 3) | __builtin_ctz(byte), captures);
+}
+
+void rr_bitset_and(uint8_t *dst, uint8_t *a, uint8_t *b, uint64_t size)
+{
+    for (uint64_t i = 0; i < size; i += 8)
+        store_word(dst + i, load_word(a + i) & load_word(b + i));
+}
+
+void rr_bitset_andnot(uint8_t *dst, uint8_t *a, uint8_t *b, uint64_t size)
+{
+    for (uint64_t i = 0; i < size; i += 8)
+        store_word(dst + i, load_word(a + i) & ~load_word(b + i));
+}
+
+void rr_bitset_or(uint8_t *dst, uint8_t *a, uint8_t *b, uint64_t size)
+{
+    for (uint64_t i = 0; i < size; i += 8)
+        store_word(dst + i, load_word(a + i) | load_word(b + i));
+}
+
+uint64_t rr_bitset_popcount(uint8_t *a, uint64_t size)
+{
+    uint64_t count = 0;
+    for (uint64_t i = 0; i < size; i += 8)
+        count += __builtin_popcountll(load_word(a + i));
+    return count;
 }
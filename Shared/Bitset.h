@@ -18,7 +18,8 @@
 
 #include <stdint.h>
 
-#define RR_BITSET_ROUND(x) ((x + 7) >> 3)
+// bytes needed for x bits, rounded up to whole 64 bit words
+#define RR_BITSET_ROUND(x) ((((x) + 63) >> 6) << 3)
 // #define RR_BITSET_ROUND(x) (x)
 
 // May return any number that is 1, 2, 4, 8, 16, 32, 64, 128.
@@ -30,7 +31,18 @@ uint8_t rr_bitset_get(uint8_t *, uint64_t);
 void rr_bitset_unset(uint8_t *, uint64_t);
 void rr_bitset_set(uint8_t *, uint64_t);
 void rr_bitset_maybe_set(uint8_t *, uint64_t, uint8_t);
+// Visits set bits in increasing order, a word at a time. Bits the callback
+// sets in the word being visited are not picked up
 void rr_bitset_for_each_bit(uint8_t *start, uint8_t *end, void *,
                             void (*cb)(uint64_t, void *));
 void rr_bitset_for_each_bit_until(uint8_t *start, uint8_t *end, void *,
                                   uint8_t (*cb)(uint64_t, void *));
+
+// Whole bitset operations, a 64 bit word at a time. Sizes are in bytes and
+// must be a multiple of 8 (anything from RR_BITSET_ROUND is). dst may alias
+// either input
+void rr_bitset_and(uint8_t *dst, uint8_t *, uint8_t *, uint64_t);
+// dst = a & ~b
+void rr_bitset_andnot(uint8_t *dst, uint8_t *a, uint8_t *b, uint64_t);
+void rr_bitset_or(uint8_t *dst, uint8_t *, uint8_t *, uint64_t);
+uint64_t rr_bitset_popcount(uint8_t *, uint64_t);
@@ -66,11 +66,12 @@ void rr_component_arena_free(struct rr_component_arena *this,
             rr_component_physical_set_y(physical, this_physical->y);
             float angle = rr_frand() * M_PI * 2;
             float v = rr_frand() * 5;
-            physical->velocity.x = cosf(angle) * v;
-            physical->velocity.y = sinf(angle) * v;
+            rr_vector_from_polar(
+                rr_simulation_get_velocity(simulation, physical->parent_id), v,
+                angle);
         }
     }
-    free(this->spatial_hash.cells);
+    rr_spatial_hash_free(&this->spatial_hash);
 #endif
 }
 
@@ -116,7 +116,8 @@ void rr_component_flower_set_dead(struct rr_component_flower *this,
                     rr_simulation_add_drop(simulation, drop_id);
                 rr_component_drop_set_id(drop, rr_petal_id_basic);
                 rr_component_drop_set_rarity(drop, rr_rarity_id_common);
-                drop->ticks_until_despawn = 25 * 10 * (drop->rarity + 1);
+                drop->ticks_until_despawn =
+                    RR_SERVER_TICK_RATE * 10 * (drop->rarity + 1);
                 drop->can_be_picked_up_by = squad;
                 struct rr_component_physical *drop_physical =
                     rr_simulation_add_physical(simulation, drop_id);
@@ -62,17 +62,17 @@ void rr_component_health_write(struct rr_component_health *this,
 {
     uint64_t state = this->protocol_state | (state_flags_all * is_creation);
     proto_bug_write_varuint(encoder, state, "health component state");
-    float tmp_health = this->health;
-    float tmp_max = this->max_health;
-    if (this->flags & 1)
-    {
-        this->health = this->max_health = 0;
-    }
-#define X(NAME, TYPE) RR_ENCODE_PUBLIC_FIELD(NAME, TYPE);
-    FOR_EACH_PUBLIC_FIELD
-#undef X
-    this->health = tmp_health;
-    this->max_health = tmp_max;
+    // hidden health is zeroed on the wire only, the component itself is
+    // shared by every client encoding this tick
+    uint8_t hidden = this->flags & 1;
+    if (state & state_flags_health)
+        proto_bug_write_float32(encoder, hidden ? 0 : this->health,
+                                "field health");
+    if (state & state_flags_flags)
+        proto_bug_write_uint8(encoder, this->flags, "field flags");
+    if (state & state_flags_max_health)
+        proto_bug_write_float32(encoder, hidden ? 0 : this->max_health,
+                                "field max_health");
 }
 
 void rr_component_health_do_damage(struct rr_simulation *simulation,
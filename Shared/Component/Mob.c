@@ -51,7 +51,7 @@ void rr_component_mob_init(struct rr_component_mob *this,
                            struct rr_simulation *simulation)
 {
     memset(this, 0, sizeof *this);
-    RR_SERVER_ONLY(this->ticks_to_despawn = 120 * 25;)
+    RR_SERVER_ONLY(this->ticks_to_despawn = 120 * RR_SERVER_TICK_RATE;)
 }
 
 void rr_component_mob_free(struct rr_component_mob *this,
@@ -175,14 +175,17 @@ void rr_component_mob_free(struct rr_component_mob *this,
 
             rr_component_relations_set_team(relations,
                                             rr_simulation_team_id_players);
-            drop->ticks_until_despawn = 25 * 10 * (spawn_rarities[i] + 1);
+            drop->ticks_until_despawn =
+                RR_SERVER_TICK_RATE * 10 * (spawn_rarities[i] + 1);
             drop->can_be_picked_up_by = squad;
             drop_physical->arena = physical->arena;
             if (count != 1)
             {
                 float angle = M_PI * 2 * (i + 0.65 * rr_frand()) / count;
-                rr_vector_from_polar(&drop_physical->velocity, 15 + 20 * rr_frand(), angle);
-                drop_physical->friction = 0.75;
+                rr_vector_from_polar(
+                    rr_simulation_get_velocity(simulation, entity),
+                    15 + 20 * rr_frand(), angle);
+                *rr_simulation_get_friction(simulation, entity) = 0.75;
             }
         }
     }
@@ -73,7 +73,7 @@ void rr_component_petal_free(struct rr_component_petal *this,
         physical, RR_PETAL_RARITY_SCALE[this->rarity].web_radius);
     rr_component_physical_set_angle(physical, rr_frand() * 2 * M_PI);
     physical->mass = 1;
-    physical->friction = 0;
+    *rr_simulation_get_friction(simulation, id) = 0;
     physical->arena = petal_phys->arena;
     web->ticks_until_death = 125;
     web->slow_factor = powf(0.56, this->rarity);
@@ -16,8 +16,10 @@
 
 #include <Shared/Component/Physical.h>
 
+#include <math.h>
 #include <string.h>
 
+#include <Shared/SimulationCommon.h>
 #include <Shared/pb.h>
 
 enum
@@ -29,18 +31,33 @@ enum
     state_flags_all = 0b01111
 };
 
-#define FOR_EACH_PUBLIC_FIELD                                                  \
-    X(angle, float32)                                                          \
-    X(radius, float32)                                                         \
-    X(x, float32)                                                              \
-    X(y, float32)
+// positions go over the wire in 1/16ths of a unit, as a zigzag varint
+// delta from the last sent value or absolute on creation. angles are a byte
+#define RR_POSITION_SCALE (16)
+#define RR_ANGLE_STEPS (256)
+
+static int32_t quantize_position(float x)
+{
+    return (int32_t)lroundf(x * RR_POSITION_SCALE);
+}
+
+#ifdef RR_SERVER
+static void reset_motion(struct rr_simulation *simulation, EntityIdx entity)
+{
+    rr_vector_set(rr_simulation_get_velocity(simulation, entity), 0, 0);
+    rr_vector_set(rr_simulation_get_acceleration(simulation, entity), 0, 0);
+    rr_vector_set(rr_simulation_get_collision_velocity(simulation, entity), 0,
+                  0);
+    *rr_simulation_get_friction(simulation, entity) = 0;
+    *rr_simulation_get_acceleration_scale(simulation, entity) = 1;
+}
+#endif
 
 void rr_component_physical_init(struct rr_component_physical *this,
                                 struct rr_simulation *simulation)
 {
     memset(this, 0, sizeof *this);
     RR_SERVER_ONLY(this->mass = 1;)
-    RR_SERVER_ONLY(this->acceleration_scale = 1;)
     RR_SERVER_ONLY(this->knockback_scale = 1;)
     RR_SERVER_ONLY(this->aggro_range_multiplier = 1;)
 }
@@ -48,6 +65,9 @@ void rr_component_physical_init(struct rr_component_physical *this,
 void rr_component_physical_free(struct rr_component_physical *this,
                                 struct rr_simulation *simulation)
 {
+    // the velocity system runs over every slot, so unused ones are kept at
+    // rest and ready for the next entity (see rr_simulation_init)
+    RR_SERVER_ONLY(reset_motion(simulation, this->parent_id);)
 }
 
 #ifdef RR_SERVER
@@ -57,9 +77,37 @@ void rr_component_physical_write(struct rr_component_physical *this,
 {
     uint64_t state = this->protocol_state | (state_flags_all * is_creation);
     proto_bug_write_varuint(encoder, state, "physical component state");
-#define X(NAME, TYPE) RR_ENCODE_PUBLIC_FIELD(NAME, TYPE);
-    FOR_EACH_PUBLIC_FIELD
-#undef X
+    if (state & state_flags_angle)
+        proto_bug_write_uint8(
+            encoder,
+            (uint8_t)lroundf(this->angle * (RR_ANGLE_STEPS / (2 * M_PI))),
+            "field angle");
+    if (state & state_flags_radius)
+        proto_bug_write_float32(encoder, this->radius, "field radius");
+    if (state & state_flags_x)
+    {
+        int32_t x = quantize_position(this->x);
+        if (!is_creation)
+            x -= this->sent_x;
+        proto_bug_write_varuint(encoder, ((uint32_t)x << 1) ^ (x >> 31),
+                                "field x");
+    }
+    if (state & state_flags_y)
+    {
+        int32_t y = quantize_position(this->y);
+        if (!is_creation)
+            y -= this->sent_y;
+        proto_bug_write_varuint(encoder, ((uint32_t)y << 1) ^ (y >> 31),
+                                "field y");
+    }
+}
+
+void rr_component_physical_update_sent(struct rr_component_physical *this)
+{
+    if (this->protocol_state & state_flags_x)
+        this->sent_x = quantize_position(this->x);
+    if (this->protocol_state & state_flags_y)
+        this->sent_y = quantize_position(this->y);
 }
 
 RR_DEFINE_PUBLIC_FIELD(physical, float, x)
@@ -74,8 +122,25 @@ void rr_component_physical_read(struct rr_component_physical *this,
 {
     uint64_t state =
         proto_bug_read_varuint(encoder, "physical component state");
-#define X(NAME, TYPE) RR_DECODE_PUBLIC_FIELD(NAME, TYPE);
-    FOR_EACH_PUBLIC_FIELD
-#undef X
+    // new entities start zeroed so absolute values decode as deltas from 0
+    if (state & state_flags_angle)
+        this->angle = proto_bug_read_uint8(encoder, "field angle") *
+                      (2 * M_PI / RR_ANGLE_STEPS);
+    if (state & state_flags_radius)
+        this->radius = proto_bug_read_float32(encoder, "field radius");
+    if (state & state_flags_x)
+    {
+        uint32_t x = proto_bug_read_varuint(encoder, "field x");
+        int32_t delta = (x >> 1) ^ -(x & 1);
+        this->x = (quantize_position(this->x) + delta) /
+                  (float)RR_POSITION_SCALE;
+    }
+    if (state & state_flags_y)
+    {
+        uint32_t y = proto_bug_read_varuint(encoder, "field y");
+        int32_t delta = (y >> 1) ^ -(y & 1);
+        this->y = (quantize_position(this->y) + delta) /
+                  (float)RR_POSITION_SCALE;
+    }
 }
 #endif
\ No newline at end of file
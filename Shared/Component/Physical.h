@@ -29,19 +29,15 @@ RR_SERVER_ONLY(struct rr_component_player_info;)
 
 struct rr_component_physical
 {
-    struct rr_vector velocity;
+    // velocity, acceleration, collision velocity, friction and acceleration
+    // scale live in rr_simulation::motion on the server
+    RR_CLIENT_ONLY(struct rr_vector velocity;)
     RR_CLIENT_ONLY(struct rr_vector lerp_velocity;)
-    RR_SERVER_ONLY(struct rr_vector
-                       collision_velocity;) // used for collision resolution
-                                            // calcs. bypasses all speed modifie
-    RR_SERVER_ONLY(struct rr_vector acceleration;)
     RR_SERVER_ONLY(
         struct rr_vector wall_collision;) // wall collision angle. can be used
                                           // to bounce off walls
     RR_SERVER_ONLY(float mass;)
     RR_SERVER_ONLY(float knockback_scale;)
-    RR_SERVER_ONLY(float friction;)
-    RR_SERVER_ONLY(float acceleration_scale;)
     RR_SERVER_ONLY(float aggro_range_multiplier;)
     RR_SERVER_ONLY(float slow_resist;)
     RR_SERVER_ONLY(float web_slowdown;)
@@ -65,10 +61,11 @@ struct rr_component_physical
     RR_CLIENT_ONLY(uint8_t deletion_type : 2;)
     RR_CLIENT_ONLY(uint8_t animation_started : 1;)
     RR_SERVER_ONLY(uint8_t protocol_state;)
+    // quantized position clients were last sent, deltas are taken from it
+    RR_SERVER_ONLY(int32_t sent_x;)
+    RR_SERVER_ONLY(int32_t sent_y;)
     EntityIdx parent_id;
     RR_SERVER_ONLY(EntityIdx arena;)
-    RR_SERVER_ONLY(uint16_t colliding_with_size;)
-    RR_SERVER_ONLY(EntityIdx colliding_with[RR_MAX_COLLISION_COUNT];)
 };
 
 void rr_component_physical_init(struct rr_component_physical *,
@@ -79,6 +76,10 @@ void rr_component_physical_free(struct rr_component_physical *,
 RR_SERVER_ONLY(void rr_component_physical_write(
                    struct rr_component_physical *, struct proto_bug *, int,
                    struct rr_component_player_info *);)
+// call after every client was encoded for the tick, before protocol_state is
+// reset
+RR_SERVER_ONLY(
+    void rr_component_physical_update_sent(struct rr_component_physical *);)
 RR_CLIENT_ONLY(void rr_component_physical_read(struct rr_component_physical *,
                                                struct proto_bug *);)
 
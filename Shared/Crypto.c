@@ -17,7 +17,6 @@
 #include <Shared/Crypto.h>
 
 #include <stdint.h>
-#include <stdlib.h>
 #include <string.h>
 
 #include <Shared/MagicNumber.h>
@@ -42,34 +41,50 @@ static inline uint32_t u8t32le(uint8_t p[4])
     return value;
 }
 
-static inline uint32_t rotl32(uint32_t x, int n)
-{
-    // http://blog.regehr.org/archives/1063
-    return x << n | (x >> (-n & 31));
-}
+// Several consecutive blocks are computed at once, one per vector lane. Plain
+// vector extensions so this is sse2 or avx2 on the server and simd128 on the
+// client. Note the rounds and the constants aren't standard chacha20, they
+// have to match between client and server and not the rfc
+#ifdef __AVX2__
+#define RR_CHACHA20_LANES (8)
+#else
+#define RR_CHACHA20_LANES (4)
+#endif
+
+typedef uint32_t chacha20_vector
+    __attribute__((vector_size(RR_CHACHA20_LANES * sizeof(uint32_t))));
+
+#define chacha20_rotl(x, n) ((x) << (n) | (x) >> (32 - (n)))
 
 // https://tools.ietf.org/html/rfc7539#section-2.1
-static void chacha20_quarterround(uint32_t *x, int a, int b, int c, int d)
-{
-    x[a] += x[b];
-    x[d] = rotl32(x[d] ^ x[a], 16);
-    x[c] += x[d];
-    x[b] = rotl32(x[b] ^ x[c], 12);
-    x[a] += x[b];
-    x[d] = rotl32(x[d] ^ x[a], 8);
-    x[c] += x[d];
-    x[b] = rotl32(x[b] ^ x[c], 7);
-}
+#define chacha20_quarterround(x, a, b, c, d)                                   \
+    do                                                                         \
+    {                                                                          \
+        x[a] += x[b];                                                          \
+        x[d] = chacha20_rotl(x[d] ^ x[a], 16);                                 \
+        x[c] += x[d];                                                          \
+        x[b] = chacha20_rotl(x[b] ^ x[c], 12);                                 \
+        x[a] += x[b];                                                          \
+        x[d] = chacha20_rotl(x[d] ^ x[a], 8);                                  \
+        x[c] += x[d];                                                          \
+        x[b] = chacha20_rotl(x[b] ^ x[c], 7);                                  \
+    } while (0)
 
 static void chacha20_serialize(uint32_t in[16], uint8_t output[64])
 {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    memcpy(output, in, 64);
+#else
     int i;
     for (i = 0; i < 16; i++)
     {
         u32t8le(in[i], output + (i << 2));
     }
+#endif
 }
 
+// a single block for short tails, the vector version would throw most of its
+// work away
 static void chacha20_block(uint32_t in[16], uint8_t out[64], int num_rounds)
 {
     int i;
@@ -97,6 +112,53 @@ static void chacha20_block(uint32_t in[16], uint8_t out[64], int num_rounds)
     chacha20_serialize(x, out);
 }
 
+// RR_CHACHA20_LANES blocks starting at counter in[12]
+static void chacha20_blocks(uint32_t in[16],
+                            uint8_t out[RR_CHACHA20_LANES * 64],
+                            int num_rounds)
+{
+    int i;
+    chacha20_vector start[16];
+    chacha20_vector x[16];
+
+    for (i = 0; i < 16; i++)
+    {
+        start[i] = (chacha20_vector){0} + in[i];
+    }
+    for (i = 0; i < RR_CHACHA20_LANES; i++)
+    {
+        start[12][i] += i;
+    }
+    memcpy(x, start, sizeof x);
+
+    for (i = num_rounds; i > 0; i -= 2)
+    {
+        chacha20_quarterround(x, 0, 4, 8, 12);
+        chacha20_quarterround(x, 1, 5, 9, 13);
+        chacha20_quarterround(x, 2, 6, 10, 14);
+        chacha20_quarterround(x, 3, 7, 11, 15);
+        chacha20_quarterround(x, 1, 5, 10, 15);
+        chacha20_quarterround(x, 1, 6, 11, 14);
+        chacha20_quarterround(x, 2, 7, 8, 13);
+        chacha20_quarterround(x, 3, 4, 9, 14);
+    }
+
+    // word major to block major
+    uint32_t words[16][RR_CHACHA20_LANES];
+    for (i = 0; i < 16; i++)
+    {
+        x[i] += start[i];
+        memcpy(words[i], &x[i], sizeof x[i]);
+    }
+    for (i = 0; i < RR_CHACHA20_LANES; i++)
+    {
+        uint32_t block[16];
+        for (int j = 0; j < 16; j++)
+            block[j] = words[j][i];
+        chacha20_serialize(block, out + i * 64);
+    }
+}
+
 // https://tools.ietf.org/html/rfc7539#section-2.3
 static void chacha20_init_state(uint32_t s[16], uint8_t key[32],
                                 uint32_t counter, uint8_t nonce[12])
@@ -124,29 +186,35 @@ static void chacha20_init_state(uint32_t s[16], uint8_t key[32],
     }
 }
 
+// in place
 static void ChaCha20XOR(uint8_t key[32], uint32_t counter, uint8_t nonce[12],
-                        uint8_t *in, uint8_t *out, int inlen)
+                        uint8_t *data, uint64_t size)
 {
-    int i, j;
-
     uint32_t s[16];
-    uint8_t block[64];
+    uint8_t block[RR_CHACHA20_LANES * 64];
 
     chacha20_init_state(s, key, counter, nonce);
 
-    for (i = 0; i < inlen; i += 64)
+    for (uint64_t i = 0; i < size; i += sizeof block)
     {
-        chacha20_block(s, block, 20);
-        s[12]++;
-
-        for (j = i; j < i + 64; j++)
+        uint64_t length = size - i < sizeof block ? size - i : sizeof block;
+        if (length <= 64)
+            chacha20_block(s, block, 20);
+        else
+            chacha20_blocks(s, block, 20);
+        s[12] += RR_CHACHA20_LANES;
+
+        uint64_t j = 0;
+        for (; j + 8 <= length; j += 8)
         {
-            if (j >= inlen)
-            {
-                break;
-            }
-            out[j] = in[j] ^ block[j - i];
+            uint64_t a, b;
+            memcpy(&a, data + i + j, 8);
+            memcpy(&b, block + j, 8);
+            a ^= b;
+            memcpy(data + i + j, &a, 8);
         }
+        for (; j < length; j++)
+            data[i + j] ^= block[j];
     }
 }
 
@@ -165,8 +233,6 @@ uint64_t rr_get_rand() { return g_random_seed = rr_get_hash(g_random_seed); }
 
 void rr_encrypt(uint8_t *start, uint64_t size, uint64_t key)
 {
-    uint8_t *clone = malloc(size);
-    memcpy(clone, start, size);
     uint64_t cipher_key[4];
     // idk what the nonce is for but it gets initialized with random bytes
     uint32_t nonce[3];
@@ -180,9 +246,7 @@ void rr_encrypt(uint8_t *start, uint64_t size, uint64_t key)
         nonce[i] = key = rr_get_hash(rr_get_hash(key));
     counter = rr_get_hash(key);
 
-    ChaCha20XOR((uint8_t *)cipher_key, counter, (uint8_t *)nonce, clone, start,
-                size);
-    free(clone);
+    ChaCha20XOR((uint8_t *)cipher_key, counter, (uint8_t *)nonce, start, size);
 }
 
 void rr_decrypt(uint8_t *start, uint64_t size, uint64_t key)
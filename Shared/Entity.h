@@ -18,16 +18,28 @@
 
 #include <stdint.h>
 
+// Set at build time with -DRR_MAX_ENTITY_COUNT (the MAX_ENTITY_COUNT cmake
+// option), the server and the client have to agree on it. Caps past 16 bits
+// switch to 32 bit indices
+#ifndef RR_MAX_ENTITY_COUNT
+#define RR_MAX_ENTITY_COUNT (16384)
+#endif
+
+#if RR_MAX_ENTITY_COUNT > 65535
+typedef uint32_t EntityIdx;
+typedef uint64_t EntityHash;
+#else
 typedef uint16_t EntityIdx;
 typedef uint32_t EntityHash;
+#endif
 
-#define RR_MAX_ENTITY_COUNT (16384)
+// EntityHash keeps the entity's generation right above its index
+#define RR_ENTITY_HASH_SHIFT (8 * sizeof(EntityIdx))
 #define RR_NULL_ENTITY (0)
 #define RR_SQUAD_MEMBER_COUNT (4)
 
 #define RR_MAX_CLIENT_COUNT (64)
 #define RR_SQUAD_COUNT (RR_MAX_CLIENT_COUNT)
-#define RR_MAX_COLLISION_COUNT (256)
 
 #define RR_MAX_SLOT_COUNT (12)
 
@@ -51,3 +63,13 @@ struct rr_id_rarity_pair
     XX(player_info, 1)                                                         \
     XX(petal, 8)                                                               \
     XX(nest, 13)
+
+// Bits of rr_simulation::entity_tracker, for testing several components at once
+enum rr_component_mask
+{
+#define XX(COMPONENT, ID) rr_component_mask_##COMPONENT = 1 << ID,
+    RR_FOR_EACH_COMPONENT
+#undef XX
+    // matches any entity in a filter's include
+    rr_component_mask_any = 0xffff
+};
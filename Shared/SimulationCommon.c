@@ -46,8 +46,16 @@ void __rr_simulation_pending_deletion_free_components(uint64_t i,
     assert(rr_simulation_has_entity(this, i));
 #define XX(COMPONENT, ID)                                                      \
     if (rr_simulation_has_##COMPONENT(this, i))                                \
+    {                                                                          \
         rr_component_##COMPONENT##_free(                                       \
-            rr_simulation_get_##COMPONENT(this, i), this);
+            rr_simulation_get_##COMPONENT(this, i), this);                     \
+        this->COMPONENT##_free_slots[this->COMPONENT##_free_slot_count++] =    \
+            this->COMPONENT##_slots[i];                                        \
+        EntityIdx last = this->COMPONENT##_vector[--this->COMPONENT##_count];  \
+        EntityIdx at = this->COMPONENT##_vector_index[i];                      \
+        this->COMPONENT##_vector[at] = last;                                   \
+        this->COMPONENT##_vector_index[last] = at;                             \
+    }
     RR_FOR_EACH_COMPONENT;
 #undef XX
 }
@@ -63,21 +71,13 @@ void __rr_simulation_pending_deletion_unset_entity(uint64_t i, void *captures)
     this->entity_tracker[(EntityIdx)i] = 0;
 }
 
-void rr_simulation_create_component_vectors(struct rr_simulation *this)
+void rr_simulation_free_component_pools(struct rr_simulation *this)
 {
-#define XX(COMPONENT, ID) this->COMPONENT##_count = 0;
-    RR_FOR_EACH_COMPONENT;
-#undef XX
-    for (EntityIdx entity = 1; entity < RR_MAX_ENTITY_COUNT; ++entity)
-    {
-        if (!(this->entity_tracker[entity] & 1))
-            continue;
 #define XX(COMPONENT, ID)                                                      \
-    if (this->entity_tracker[entity] & (1 << ID))                              \
-        this->COMPONENT##_vector[this->COMPONENT##_count++] = entity;
-        RR_FOR_EACH_COMPONENT;
+    for (uint32_t i = 0; i < RR_COMPONENT_CHUNK_COUNT; ++i)                    \
+        free(this->COMPONENT##_chunks[i]);
+    RR_FOR_EACH_COMPONENT;
 #undef XX
-    }
 }
 
 void rr_simulation_for_each_entity(struct rr_simulation *this,
@@ -110,18 +110,32 @@ void rr_simulation_for_each_entity(struct rr_simulation *this,
         struct rr_simulation *this, EntityIdx entity)                          \
     {                                                                          \
         assert(rr_simulation_has_entity(this, entity));                        \
+        EntityIdx slot =                                                       \
+            this->COMPONENT##_free_slot_count                                  \
+                ? this->COMPONENT##_free_slots                                 \
+                      [--this->COMPONENT##_free_slot_count]                    \
+                : this->COMPONENT##_slot_count++;                              \
+        struct rr_component_##COMPONENT **chunk =                              \
+            &this->COMPONENT##_chunks[slot / RR_COMPONENT_CHUNK_SIZE];         \
+        if (*chunk == NULL)                                                    \
+            *chunk = malloc(RR_COMPONENT_CHUNK_SIZE * sizeof **chunk);         \
+        struct rr_component_##COMPONENT *component =                           \
+            &(*chunk)[slot % RR_COMPONENT_CHUNK_SIZE];                         \
+        this->COMPONENT##_slots[entity] = slot;                                \
         this->entity_tracker[entity] |= (1 << ID);                             \
-        rr_component_##COMPONENT##_init(&this->COMPONENT##_components[entity], \
-                                        this);                                 \
-        this->COMPONENT##_components[entity].parent_id = entity;               \
+        rr_component_##COMPONENT##_init(component, this);                      \
+        component->parent_id = entity;                                         \
+        this->COMPONENT##_vector_index[entity] = this->COMPONENT##_count;      \
         this->COMPONENT##_vector[this->COMPONENT##_count++] = entity;          \
-        return rr_simulation_get_##COMPONENT(this, entity);                    \
+        return component;                                                      \
     }                                                                          \
     struct rr_component_##COMPONENT *rr_simulation_get_##COMPONENT(            \
         struct rr_simulation *this, EntityIdx entity)                          \
     {                                                                          \
         assert(rr_simulation_has_##COMPONENT(this, entity));                   \
-        return &this->COMPONENT##_components[entity];                          \
+        EntityIdx slot = this->COMPONENT##_slots[entity];                      \
+        return &this->COMPONENT##_chunks[slot / RR_COMPONENT_CHUNK_SIZE]       \
+                                        [slot % RR_COMPONENT_CHUNK_SIZE];      \
     }
 RR_FOR_EACH_COMPONENT;
 #undef XX
@@ -80,6 +80,62 @@ enum rr_simulation_team_id
      (team2 == rr_simulation_team_id_players &&                                \
       team1 >= rr_simulation_team_id_pvp))
 
+#ifdef RR_SERVER
+// Integration state of physical entities in flat arrays indexed by entity, so
+// the velocity system can stream over it instead of pulling in whole physical
+// components. Slots of entities without physical stay zeroed
+struct rr_simulation_motion
+{
+    struct rr_vector velocity[RR_MAX_ENTITY_COUNT];
+    struct rr_vector acceleration[RR_MAX_ENTITY_COUNT];
+    struct rr_vector collision_velocity[RR_MAX_ENTITY_COUNT];
+    float friction[RR_MAX_ENTITY_COUNT];
+    float acceleration_scale[RR_MAX_ENTITY_COUNT];
+};
+
+// Hands out entity ids in O(1). Recycled ids come off a ring before ids that
+// were never used. Ids deleted at the end of a tick sit in quarantine through
+// the next tick (the window deleted_last_tick covers) before going back on it
+struct rr_simulation_entity_allocator
+{
+    EntityIdx free[RR_MAX_ENTITY_COUNT];
+    EntityIdx quarantine[RR_MAX_ENTITY_COUNT];
+    uint32_t free_start;
+    uint32_t free_count;
+    uint32_t quarantine_count;
+    // ids 1 to fresh_count have been handed out at least once
+    uint32_t fresh_count;
+    uint32_t live_count;
+    // allocation pressure since the last report
+    uint32_t allocations;
+    uint32_t recycled_allocations;
+    uint32_t releases;
+    uint32_t peak_live_count;
+    uint32_t tick_count;
+};
+
+// Every touching pair collision detection found this tick. Pairs are staged
+// in the order they are found, then grouped by their first entity so that
+// entity i touches counts[i] entities starting at entities[starts[i]]. Only
+// entities listed in touched have a non zero count
+struct rr_simulation_contacts
+{
+    EntityIdx *pending;
+    EntityIdx *entities;
+    EntityIdx *touched;
+    uint32_t starts[RR_MAX_ENTITY_COUNT];
+    uint32_t counts[RR_MAX_ENTITY_COUNT];
+    uint32_t count;
+    uint32_t touched_count;
+    uint32_t capacity;
+};
+#endif
+
+#define RR_COMPONENT_CHUNK_SIZE (256)
+#define RR_COMPONENT_CHUNK_COUNT                                               \
+    ((RR_MAX_ENTITY_COUNT + RR_COMPONENT_CHUNK_SIZE - 1) /                     \
+     RR_COMPONENT_CHUNK_SIZE)
+
 struct rr_simulation
 {
     uint16_t entity_tracker[RR_MAX_ENTITY_COUNT];
@@ -88,13 +144,27 @@ struct rr_simulation
     RR_SERVER_ONLY(
         uint8_t deleted_last_tick[RR_BITSET_ROUND(RR_MAX_ENTITY_COUNT)];)
 
+    // Components live in a sparse set per type: COMPONENT_slots maps an entity
+    // to its slot in COMPONENT_chunks, which are only allocated once that many
+    // components exist. Freed slots are handed out again before new ones, and
+    // components never move while their entity is alive. COMPONENT_vector
+    // lists every entity with the component, kept up to date on add and free
+    // with vector_index pointing back into it
 #define XX(COMPONENT, ID)                                                      \
     struct rr_component_##COMPONENT                                            \
-        COMPONENT##_components[RR_MAX_ENTITY_COUNT];                           \
+        *COMPONENT##_chunks[RR_COMPONENT_CHUNK_COUNT];                         \
+    EntityIdx COMPONENT##_slots[RR_MAX_ENTITY_COUNT];                          \
+    EntityIdx COMPONENT##_free_slots[RR_MAX_ENTITY_COUNT];                     \
+    EntityIdx COMPONENT##_free_slot_count;                                     \
+    EntityIdx COMPONENT##_slot_count;                                          \
     EntityIdx COMPONENT##_vector[RR_MAX_ENTITY_COUNT];                         \
+    EntityIdx COMPONENT##_vector_index[RR_MAX_ENTITY_COUNT];                   \
     EntityIdx COMPONENT##_count;
     RR_FOR_EACH_COMPONENT;
 #undef XX
+    RR_SERVER_ONLY(struct rr_simulation_entity_allocator entity_allocator;)
+    RR_SERVER_ONLY(struct rr_simulation_motion motion;)
+    RR_SERVER_ONLY(struct rr_simulation_contacts contacts;)
     RR_SERVER_ONLY(struct rr_simulation_animation animations[16384];)
     RR_SERVER_ONLY(uint32_t animation_length;)
     RR_SERVER_ONLY(struct rr_server *server;)
@@ -107,7 +177,9 @@ int rr_simulation_has_entity(struct rr_simulation *, EntityIdx);
 void rr_simulation_request_entity_deletion(struct rr_simulation *, EntityIdx);
 void rr_simulation_for_each_entity(struct rr_simulation *, void *,
                                    void (*)(EntityIdx, void *));
-void rr_simulation_create_component_vectors(struct rr_simulation *);
+// Releases every component chunk. The simulation must be zeroed or
+// initialized before
+void rr_simulation_free_component_pools(struct rr_simulation *);
 
 // internal use
 void __rr_simulation_pending_deletion_free_components(uint64_t, void *);
@@ -123,3 +195,22 @@ void __rr_simulation_pending_deletion_unset_entity(uint64_t, void *);
                                             void (*)(EntityIdx, void *));
 RR_FOR_EACH_COMPONENT
 #undef XX
+
+#ifdef RR_SERVER
+// slots of rr_simulation::motion, valid for any entity with physical
+#define RR_FOR_EACH_MOTION_FIELD                                               \
+    XX(struct rr_vector, velocity)                                             \
+    XX(struct rr_vector, acceleration)                                         \
+    XX(struct rr_vector, collision_velocity)                                   \
+    XX(float, friction)                                                        \
+    XX(float, acceleration_scale)
+
+#define XX(TYPE, FIELD)                                                        \
+    static inline TYPE *rr_simulation_get_##FIELD(struct rr_simulation *this,  \
+                                                  EntityIdx id)                \
+    {                                                                          \
+        return &this->motion.FIELD[id];                                        \
+    }
+RR_FOR_EACH_MOTION_FIELD
+#undef XX
+#endif
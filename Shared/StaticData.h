@@ -63,7 +63,9 @@ enum rr_clientbound_packet_header
     rr_clientbound_squad_fail,
     rr_clientbound_squad_leave,
     rr_clientbound_account_result,
-    rr_clientbound_craft_result
+    rr_clientbound_craft_result,
+    // a uint32 size and then the message, repeated until the end
+    rr_clientbound_bundle
 };
 
 enum rr_dev_cheat_type
@@ -72,6 +72,14 @@ extern "C"
         self->start = data;
         self->current = data;
         self->end = (uint8_t *)-1;
+        self->deferred = 0;
+        self->overflowed = 0;
+    }
+
+    void proto_bug_init_deferred(struct proto_bug *self, uint8_t *data)
+    {
+        proto_bug_init(self, data);
+        self->deferred = RR_SECRET8;
     }
 
     void proto_bug_set_bound(struct proto_bug *self, uint8_t *end)
@@ -89,53 +97,124 @@ extern "C"
         return self->current - self->start;
     }
 
+    // xor a whole run of bytes with the same mask, a word at a time
+    static void mask_bytes(uint8_t *data, uint64_t size, uint8_t mask)
+    {
+        uint64_t wide = mask * 0x0101010101010101ull;
+        uint64_t i = 0;
+        for (; i + 8 <= size; i += 8)
+        {
+            uint64_t word;
+            memcpy(&word, data + i, sizeof word);
+            word ^= wide;
+            memcpy(data + i, &word, sizeof word);
+        }
+        for (; i < size; ++i)
+            data[i] ^= mask;
+    }
+
+    void proto_bug_finalize(struct proto_bug *self)
+    {
+        mask_bytes(self->start, self->current - self->start, self->deferred);
+    }
+
+    void proto_bug_unmask(struct proto_bug *self, uint64_t size)
+    {
+        mask_bytes(self->start, size, self->deferred);
+    }
+
+    static uint8_t has_room(struct proto_bug *self, uint64_t size)
+    {
+        if (self->current + size <= self->end)
+            return 1;
+        self->overflowed = 1;
+        return 0;
+    }
+
+    // multi byte values go in one store. uint16 and uint32 bytes end up masked
+    // with just their index since the low byte of RR_SECRET32 ^ n cancels out
+    // with RR_SECRET8
+    static void store_big_endian(struct proto_bug *self, uint64_t data,
+                                 uint64_t size)
+    {
+        data ^= (self->deferred * 0x0101010101010101ull);
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        data = __builtin_bswap64(data) >> (64 - size * 8);
+        memcpy(self->current, &data, size);
+#else
+        for (uint64_t i = 0; i < size; ++i)
+            self->current[i] = data >> ((size - 1 - i) * 8);
+#endif
+        self->current += size;
+    }
+
+    static uint64_t load_big_endian(struct proto_bug *self, uint64_t size)
+    {
+        uint64_t data = 0;
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        memcpy(&data, self->current, size);
+        data = __builtin_bswap64(data) >> (64 - size * 8);
+#else
+        for (uint64_t i = 0; i < size; ++i)
+            data = (data << 8) | self->current[i];
+#endif
+        self->current += size;
+        return data ^ ((self->deferred * 0x0101010101010101ull) >>
+                       (64 - size * 8));
+    }
+
+    void proto_bug_write_bytes(struct proto_bug *self, uint8_t const *data,
+                               uint64_t size)
+    {
+        if (!has_room(self, size))
+            return;
+        memcpy(self->current, data, size);
+        self->current += size;
+    }
+
     void proto_bug_write_uint8_internal(struct proto_bug *self, uint8_t data)
     {
-        *self->current++ = data ^ RR_SECRET8 ^ 0;
+        if (!has_room(self, 1))
+            return;
+        *self->current++ = data ^ RR_SECRET8 ^ self->deferred;
     }
     void proto_bug_write_uint16_internal(struct proto_bug *self, uint16_t data)
     {
-        proto_bug_write_uint8_internal(self, RR_SECRET32 ^ 1 ^
-                                                 ((data & 0xff00) >> 8));
-        proto_bug_write_uint8_internal(self, RR_SECRET32 ^ 2 ^ (data & 0xff));
+        if (!has_room(self, 2))
+            return;
+        store_big_endian(self, data ^ 0x0102u, 2);
     }
     void proto_bug_write_uint32_internal(struct proto_bug *self, uint32_t data)
     {
-        proto_bug_write_uint8_internal(self, RR_SECRET32 ^ 3 ^
-                                                 ((data & 0xff000000) >> 24));
-        proto_bug_write_uint8_internal(self, RR_SECRET32 ^ 4 ^
-                                                 ((data & 0x00ff0000) >> 16));
-        proto_bug_write_uint8_internal(self, RR_SECRET32 ^ 5 ^
-                                                 ((data & 0x0000ff00) >> 8));
-        proto_bug_write_uint8_internal(self, RR_SECRET32 ^ 6 ^ (data & 0xff));
+        if (!has_room(self, 4))
+            return;
+        store_big_endian(self, data ^ 0x03040506u, 4);
     }
     void proto_bug_write_uint64_internal(struct proto_bug *self, uint64_t data)
     {
         data += 18446744073709551604ull ^
                 100ull; // make it wraparound since javascript can't do uint64
                         // wraparound very well
-        proto_bug_write_uint8_internal(
-            self, ((data & 0xff00000000000000ull) >> 56ull));
-        proto_bug_write_uint8_internal(self,
-                                       ((data & 0xff000000000000ull) >> 48ull));
-        proto_bug_write_uint8_internal(self,
-                                       ((data & 0xff0000000000ull) >> 40ull));
-        proto_bug_write_uint8_internal(self,
-                                       ((data & 0xff00000000ull) >> 32ull));
-        proto_bug_write_uint8_internal(self, ((data & 0xff000000ull) >> 24ull));
-        proto_bug_write_uint8_internal(self, ((data & 0xff0000ull) >> 16ull));
-        proto_bug_write_uint8_internal(self, ((data & 0xff00ull) >> 8ull));
-        proto_bug_write_uint8_internal(self, (data & 0xffull));
+        if (!has_room(self, 8))
+            return;
+        store_big_endian(self, data ^ (RR_SECRET8 * 0x0101010101010101ull),
+                         8);
     }
     void proto_bug_write_float32_internal(struct proto_bug *self, float data)
     {
+        if (!has_room(self, sizeof data))
+            return;
         memcpy(self->current, &data,
                sizeof data); // the compiler is a genius and optimizes self
+        mask_bytes(self->current, sizeof data, self->deferred);
         self->current += sizeof data;
     }
     void proto_bug_write_float64_internal(struct proto_bug *self, double data)
     {
+        if (!has_room(self, sizeof data))
+            return;
         memcpy(self->current, &data, sizeof data);
+        mask_bytes(self->current, sizeof data, self->deferred);
         self->current += sizeof data;
     }
     void proto_bug_write_varuint_internal(struct proto_bug *self, uint64_t data)
@@ -164,62 +243,50 @@ extern "C"
     {
         if (self->current > self->end)
             return 0;
-        return RR_SECRET8 ^ 0 ^ *self->current++;
+        return RR_SECRET8 ^ self->deferred ^ *self->current++;
     }
     uint16_t proto_bug_read_uint16_internal(struct proto_bug *self)
     {
-        uint16_t data = 0;
-        data |= RR_SECRET32 ^ 1 ^
-                ((uint16_t)proto_bug_read_uint8_internal(self) << 8);
-        data |=
-            RR_SECRET32 ^ 2 ^ ((uint16_t)proto_bug_read_uint8_internal(self));
-
-        return data;
+        if (!has_room(self, 2))
+            return 0;
+        return load_big_endian(self, 2) ^ 0x0102u;
     }
     uint32_t proto_bug_read_uint32_internal(struct proto_bug *self)
     {
-        uint32_t data = 0;
-        data |= RR_SECRET32 ^ 3 ^
-                ((uint32_t)proto_bug_read_uint8_internal(self) << 24);
-        data |= RR_SECRET32 ^ 4 ^
-                ((uint32_t)proto_bug_read_uint8_internal(self) << 16);
-        data |= RR_SECRET32 ^ 5 ^
-                ((uint32_t)proto_bug_read_uint8_internal(self) << 8);
-        data |=
-            RR_SECRET32 ^ 6 ^ ((uint32_t)proto_bug_read_uint8_internal(self));
-
-        return data;
+        if (!has_room(self, 4))
+            return 0;
+        return load_big_endian(self, 4) ^ 0x03040506u;
     }
     uint64_t proto_bug_read_uint64_internal(struct proto_bug *self)
     {
-        uint64_t data = 0;
-        data |= ((uint64_t)proto_bug_read_uint8_internal(self) << 56ull);
-        data |= ((uint64_t)proto_bug_read_uint8_internal(self) << 48ull);
-        data |= ((uint64_t)proto_bug_read_uint8_internal(self) << 40ull);
-        data |= ((uint64_t)proto_bug_read_uint8_internal(self) << 32ull);
-        data |= ((uint64_t)proto_bug_read_uint8_internal(self) << 24ull);
-        data |= ((uint64_t)proto_bug_read_uint8_internal(self) << 16ull);
-        data |= ((uint64_t)proto_bug_read_uint8_internal(self) << 8ull);
-        data |= ((uint64_t)proto_bug_read_uint8_internal(self));
-
+        if (!has_room(self, 8))
+            return 0;
+        uint64_t data = load_big_endian(self, 8) ^
+                        (RR_SECRET8 * 0x0101010101010101ull);
         data -= 18446744073709551604ull ^ 100ull;
         return data;
     }
     float proto_bug_read_float32_internal(struct proto_bug *self)
     {
-        if (self->end && self->current + (sizeof(float)) > self->end)
+        if (!has_room(self, sizeof(float)))
             return 0;
         float data;
-        memcpy(&data, self->current, sizeof data);
+        uint8_t bytes[sizeof data];
+        memcpy(bytes, self->current, sizeof bytes);
+        mask_bytes(bytes, sizeof bytes, self->deferred);
+        memcpy(&data, bytes, sizeof data);
         self->current += sizeof data;
         return data;
     }
     double proto_bug_read_float64_internal(struct proto_bug *self)
     {
-        if (self->end && self->current + (sizeof(double)) > self->end)
+        if (!has_room(self, sizeof(double)))
             return 0;
         double data;
-        memcpy(&data, self->current, sizeof data);
+        uint8_t bytes[sizeof data];
+        memcpy(bytes, self->current, sizeof bytes);
+        mask_bytes(bytes, sizeof bytes, self->deferred);
+        memcpy(&data, bytes, sizeof data);
         self->current += sizeof data;
         return data;
     }
@@ -39,12 +39,26 @@ extern "C"
         uint8_t *start;
         uint8_t *current;
         uint8_t *end;
+        // mask that is left out while writing and reading and instead applied
+        // to the whole buffer at once. 0 unless made with
+        // proto_bug_init_deferred
+        uint8_t deferred;
+        // set once something didn't fit before the bound and was dropped
+        uint8_t overflowed;
     };
 
     void proto_bug_init(struct proto_bug *, uint8_t *);
+    // the bytes in the buffer differ from the finished message until
+    // proto_bug_finalize is called. readers have to proto_bug_unmask first
+    void proto_bug_init_deferred(struct proto_bug *, uint8_t *);
     void proto_bug_set_bound(struct proto_bug *, uint8_t *);
     void proto_bug_reset(struct proto_bug *); // go back to the beginning
     uint64_t proto_bug_get_size(struct proto_bug *);
+    void proto_bug_finalize(struct proto_bug *);
+    void proto_bug_unmask(struct proto_bug *, uint64_t size);
+    // copies bytes another encoder with the same mask already wrote
+    void proto_bug_write_bytes(struct proto_bug *, uint8_t const *,
+                               uint64_t size);
 
     void proto_bug_write_uint8_internal(struct proto_bug *, uint8_t);
     void proto_bug_write_uint16_internal(struct proto_bug *, uint16_t);